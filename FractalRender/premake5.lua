@@ -0,0 +1,67 @@
+-- Headless renderer, runs job files on machines without a display
+project "FractalRender"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++20"
+	staticruntime "on"
+
+	targetdir ("../bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("../bin-int/" .. outputdir .. "/%{prj.name}")
+
+	-- Everything of the visualizer but the UI
+	files {
+		"src/**.h",
+		"src/**.cpp",
+		"../FractalVisualizer/src/**.h",
+		"../FractalVisualizer/src/**.cpp"
+	}
+
+	removefiles {
+		"../FractalVisualizer/src/FractalApp.cpp",
+		"../FractalVisualizer/src/MainLayer.*",
+		"../FractalVisualizer/src/LayerUtils.h"
+	}
+
+	includedirs {
+		"../OpenGL-Core/vendor/spdlog/include",
+		"../OpenGL-Core/src",
+		"../OpenGL-Core/vendor",
+		"../OpenGL-Core/vendor/glm",
+		"../OpenGL-Core/vendor/Glad/include",
+		"../OpenGL-Core/vendor/imgui",
+		"../OpenGL-Core/vendor/implot",
+		"../FractalVisualizer/src",
+		"../FractalVisualizer/vendor"
+	}
+
+	links {
+		"OpenGL-Core",
+		"EGL",
+		"pthread",
+		"dl"
+	}
+
+	postbuildcommands {
+		"{RMDIR} %{cfg.targetdir}/assets",
+		"{COPYDIR} ../FractalVisualizer/assets %{cfg.targetdir}/assets"
+	}
+
+	-- Same as the visualizer, see there
+	filter "files:../FractalVisualizer/src/CpuKernelAVX2.cpp"
+		vectorextensions "AVX2"
+
+	filter "files:../FractalVisualizer/src/CpuKernelAVX512.cpp"
+		buildoptions { "-mavx512f", "-mavx512dq" }
+
+	filter "files:../FractalVisualizer/src/CpuKernel*.cpp"
+		buildoptions { "-ffp-contract=off" }
+
+	filter "configurations:Debug"
+		defines "GLCORE_DEBUG"
+		runtime "Debug"
+		symbols "on"
+
+	filter "configurations:Release"
+		defines "GLCORE_RELEASE"
+		runtime "Release"
+		optimize "on"
@@ -0,0 +1,89 @@
+#include "HeadlessContext.h"
+
+#include <glad/glad.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+static EGLDisplay GetDisplay()
+{
+	// Surfaceless first, the default display may want a running X server
+	auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (getPlatformDisplay)
+	{
+		EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+		if (display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr))
+			return display;
+	}
+
+	EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	if (display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr))
+		return display;
+
+	return EGL_NO_DISPLAY;
+}
+
+HeadlessContext::HeadlessContext()
+{
+	EGLDisplay display = GetDisplay();
+	if (display == EGL_NO_DISPLAY)
+	{
+		LOG_ERROR("Failed to initialize an EGL display");
+		exit(EXIT_FAILURE);
+	}
+	m_Display = display;
+
+	if (!eglBindAPI(EGL_OPENGL_API))
+	{
+		LOG_ERROR("EGL does not support desktop OpenGL");
+		exit(EXIT_FAILURE);
+	}
+
+	// The compute backend needs 4.3, the rest 4.0
+	EGLContext context = EGL_NO_CONTEXT;
+	for (int minor : { 6, 5, 4, 3, 2, 1, 0 })
+	{
+		const EGLint attributes[] = {
+			EGL_CONTEXT_MAJOR_VERSION, 4,
+			EGL_CONTEXT_MINOR_VERSION, minor,
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+			EGL_NONE
+		};
+
+		// No config, there is no surface to match
+		context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attributes);
+		if (context != EGL_NO_CONTEXT)
+			break;
+	}
+
+	if (context == EGL_NO_CONTEXT)
+	{
+		LOG_ERROR("Failed to create an OpenGL 4 context");
+		exit(EXIT_FAILURE);
+	}
+	m_Context = context;
+
+	if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+	{
+		LOG_ERROR("Failed to make the OpenGL context current");
+		exit(EXIT_FAILURE);
+	}
+
+	if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress))
+	{
+		LOG_ERROR("Failed to load the OpenGL functions");
+		exit(EXIT_FAILURE);
+	}
+
+	LOG_INFO("OpenGL {} on {}", (const char*)glGetString(GL_VERSION), (const char*)glGetString(GL_RENDERER));
+}
+
+HeadlessContext::~HeadlessContext()
+{
+	eglMakeCurrent(m_Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	eglDestroyContext(m_Display, m_Context);
+	eglTerminate(m_Display);
+}
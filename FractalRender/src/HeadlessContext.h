@@ -0,0 +1,20 @@
+#pragma once
+
+#include <GLCore.h>
+
+// OpenGL 4.x core context without a window or a display, on a surfaceless
+// EGL display. With no GPU, Mesa falls back to llvmpipe. Everything renders
+// into framebuffers, so nothing else is needed.
+class HeadlessContext
+{
+public:
+	HeadlessContext();
+	~HeadlessContext();
+
+	HeadlessContext(const HeadlessContext&) = delete;
+	HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+private:
+	void* m_Display = nullptr;
+	void* m_Context = nullptr;
+};
@@ -0,0 +1,250 @@
+#include "JobRunner.h"
+
+#include <GLCoreUtils.h>
+
+#include <fstream>
+#include <format>
+#include <algorithm>
+#include <ranges>
+
+static Uniform* FindUniform(ColorFunction& color, const std::string& name)
+{
+	auto it = std::ranges::find_if(color.GetUniforms(), [&name](Uniform* u) { return u->name == name; });
+	return it != color.GetUniforms().end() ? *it : nullptr;
+}
+
+static void ApplyUniform(ColorFunction& color, const UniformValue& value)
+{
+	Uniform* uniform = FindUniform(color, value.name);
+	if (!uniform)
+		throw custom_error(std::format("line {}: The color function has no uniform '{}'", value.line, value.name));
+
+	std::istringstream ss(value.value);
+	switch (uniform->type)
+	{
+	case UniformType::FLOAT:
+		ss >> ((FloatUniform*)uniform)->val;
+		break;
+	case UniformType::COLOR: {
+		glm::vec3& c = ((ColorUniform*)uniform)->color;
+		ss >> c.r >> c.g >> c.b;
+		break;
+	}
+	case UniformType::BOOL:
+		ss >> std::boolalpha >> ((BoolUniform*)uniform)->val;
+		break;
+	}
+
+	if (ss.fail() || !(ss >> std::ws).eof())
+		throw custom_error(std::format("line {}: Invalid value '{}' for the uniform '{}'", value.line, value.value, value.name));
+}
+
+JobRunner::JobRunner(std::filesystem::path assets)
+	: m_Assets(std::move(assets))
+{
+}
+
+bool JobRunner::Run(const RenderJob& job)
+{
+	try
+	{
+		return job.type == JobType::Still ? RenderStill(job) : RenderVideo(job);
+	}
+	catch (const custom_error& e)
+	{
+		LOG_ERROR("{}", e.what());
+		return false;
+	}
+}
+
+bool JobRunner::RenderStill(const RenderJob& job)
+{
+	FractalVisualizer& fract = GetFractal(job);
+	Configure(fract, job);
+
+	auto color = std::make_shared<ColorFunction>(*GetColorFunction(job));
+	for (const UniformValue& value : job.uniforms)
+		ApplyUniform(*color, value);
+	fract.SetColorFunction(color);
+
+	fract.SetDeepCenter(job.center);
+	fract.SetRadius(job.radius);
+	fract.SetSize(job.resolution);
+	fract.ResetRender();
+
+	// Pending pixels would show up as the set color, and the last ones the
+	// guessing left to compute need their steps too
+	for (int i = 0; i < job.steps || !fract.HasRunSteps(job.steps); i++)
+	{
+		fract.Update();
+		fract.Finish();
+	}
+
+	if (!GLCore::Utils::ExportTexture(fract.GetTexture(), job.output.string(), true))
+	{
+		LOG_ERROR("Failed to write '{}'", job.output.string());
+		return false;
+	}
+	return true;
+}
+
+bool JobRunner::RenderVideo(const RenderJob& job)
+{
+	// Only holds the settings, Prepare copies them
+	FractalVisualizer& fract = GetFractal(job);
+	Configure(fract, job);
+
+	auto& data = m_Video;
+	data.fileName = job.output.string();
+	data.resolution = job.resolution;
+	data.duration = job.duration;
+	data.fps = job.fps;
+	data.steps_per_frame = job.steps;
+	data.cCenter = job.juliaC;
+	data.cAmplitude = job.juliaAmplitude;
+
+	// Starts every float uniform with a single key of its value
+	data.SetColorFunction(GetColorFunction(job));
+	for (const UniformValue& value : job.uniforms)
+		ApplyUniform(*data.color, value);
+
+	for (auto& [uniform, keys] : data.uniformsKeyFrames)
+	{
+		AnimationTrack<float> jobKeys;
+		for (const UniformKey& key : job.uniformKeys)
+		{
+			if (key.name == uniform->name)
+				jobKeys.Insert(key.t, key.value);
+		}
+
+		if (jobKeys.Empty())
+			keys.SetValue(0, uniform->val);
+		else
+			keys = std::move(jobKeys);
+	}
+
+	for (const UniformKey& key : job.uniformKeys)
+	{
+		Uniform* uniform = FindUniform(*data.color, key.name);
+		if (!uniform || uniform->type != UniformType::FLOAT)
+			throw custom_error(std::format("line {}: The color function has no float uniform '{}'", job.line, key.name));
+	}
+
+	// Inserting keeps them ordered, the ones at the same time as in the file
+	data.radiusKeyFrames.Clear();
+	for (const auto& key : job.radiusKeys)
+		data.radiusKeyFrames.Insert(key.t, key.val);
+	if (data.radiusKeyFrames.Empty())
+		data.radiusKeyFrames.Insert(0.0, job.radius);
+
+	data.centerKeyFrames.Clear();
+	for (const auto& key : job.centerKeys)
+		data.centerKeyFrames.Insert(key.t, key.val);
+
+	// Deep zooms are relative to the center of the settings, which keeps all
+	// the digits of `center` when there are no keys
+	if (data.centerKeyFrames.Empty())
+	{
+		data.centerKeyFrames.Insert(0.0, CenterKey{ job.center.ToDouble(), { 0.0, 0.0 } });
+		fract.SetDeepCenter(job.center);
+	}
+	else
+		fract.SetCenter(data.centerKeyFrames.GetValue(0).pos);
+
+	data.Prepare(GetFractalPath(job), fract);
+	double dt = data.duration / (double)data.steps;
+
+	data.InvalidateRadius(dt * 1e-3);
+	data.InvalidateCenter();
+
+	if (!data.BeginEncoding())
+		return false;
+
+	size_t logged = 0;
+	EncodeStatus status;
+	while ((status = data.EncodeFrame()) == EncodeStatus::Running)
+	{
+		// Every 10%
+		const size_t progress = data.current_iter * 10 / data.steps;
+		if (progress > logged)
+		{
+			LOG_INFO("  {}% ({}/{} frames)", progress * 10, data.current_iter, data.steps);
+			logged = progress;
+		}
+	}
+	return status == EncodeStatus::Done;
+}
+
+void JobRunner::Configure(FractalVisualizer& fract, const RenderJob& job)
+{
+	fract.SetSetColor(job.setColor);
+	fract.SetIterationsPerFrame(job.iterations);
+	fract.SetMaxEpochs(job.maxEpochs);
+	fract.SetFadeThreshold(job.fadeThreshold);
+	fract.SetEqExponent(job.exponent);
+	fract.SetSmoothColor(job.smoothColor);
+	fract.SetEqualize(job.equalize);
+	fract.SetPerturbation(job.perturbation);
+	fract.SetPrecision(job.precision);
+	fract.SetBackend(job.backend);
+	fract.SetRenderMode(job.renderMode);
+	fract.SetJuliaC(job.juliaC);
+}
+
+std::filesystem::path JobRunner::GetFractalPath(const RenderJob& job) const
+{
+	// Either a shader of the assets or a path to one
+	std::filesystem::path path = job.fractal;
+	if (!path.has_extension())
+		path = m_Assets / (job.fractal + ".glsl");
+
+	if (!std::filesystem::exists(path))
+		throw custom_error(std::format("line {}: The fractal shader '{}' does not exist", job.line, path.string()));
+
+	return path;
+}
+
+FractalVisualizer& JobRunner::GetFractal(const RenderJob& job)
+{
+	const auto path = GetFractalPath(job);
+
+	auto& fract = m_Fractals[path];
+	if (!fract)
+	{
+		fract = std::make_unique<FractalVisualizer>(path);
+		fract->SetPreview(false);
+		fract->SetDynamicResolution(false);
+	}
+	return *fract;
+}
+
+std::shared_ptr<ColorFunction> JobRunner::GetColorFunction(const RenderJob& job)
+{
+	if (job.color.empty())
+		return ColorFunction::Default;
+
+	if (auto it = m_Colors.find(job.color); it != m_Colors.end())
+		return it->second;
+
+	// Either a color function of the assets or a path to one
+	std::filesystem::path path = job.color;
+	if (!path.has_extension())
+		path = m_Assets / "colors" / (job.color + ".glsl");
+
+	std::ifstream file(path);
+	if (!file)
+		throw custom_error(std::format("line {}: Could not open the color function '{}'", job.line, path.string()));
+
+	auto color = std::make_shared<ColorFunction>(path.stem().string());
+	try
+	{
+		color->Initialize(std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()));
+	}
+	catch (const std::exception& e)
+	{
+		throw custom_error(std::format("{}: {}", path.string(), e.what()));
+	}
+
+	m_Colors.emplace(job.color, color);
+	return color;
+}
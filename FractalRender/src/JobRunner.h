@@ -0,0 +1,37 @@
+#pragma once
+
+#include "RenderJob.h"
+
+#include <map>
+
+// Renders jobs one after the other without any UI. The fractals, color
+// functions and the video renderer outlive the jobs, so the ones that follow
+// reuse their shaders and buffers instead of starting over.
+class JobRunner
+{
+public:
+	// `assets` holds the fractal shaders and the colors folder
+	JobRunner(std::filesystem::path assets);
+
+	// False if the job failed, the error is already logged
+	bool Run(const RenderJob& job);
+
+private:
+	bool RenderStill(const RenderJob& job);
+	bool RenderVideo(const RenderJob& job);
+
+	// Sets everything but the size, the view and the color function
+	void Configure(FractalVisualizer& fract, const RenderJob& job);
+
+	std::filesystem::path GetFractalPath(const RenderJob& job) const;
+	FractalVisualizer& GetFractal(const RenderJob& job);
+	std::shared_ptr<ColorFunction> GetColorFunction(const RenderJob& job);
+
+	std::filesystem::path m_Assets;
+
+	// By source, parsed once
+	std::map<std::filesystem::path, std::unique_ptr<FractalVisualizer>> m_Fractals;
+	std::map<std::string, std::shared_ptr<ColorFunction>> m_Colors;
+
+	VideoRenderer m_Video;
+};
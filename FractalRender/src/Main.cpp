@@ -0,0 +1,70 @@
+#include "HeadlessContext.h"
+#include "JobRunner.h"
+
+// Renders the jobs of the given files without opening a window:
+//
+//     FractalRender [--assets <folder>] <jobs file>...
+//
+// See LoadJobs for the format of the files.
+int main(int argc, char** argv)
+{
+	GLCore::Log::Init();
+
+	std::filesystem::path assets = "assets";
+	std::vector<std::filesystem::path> files;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string_view arg = argv[i];
+		if (arg == "--assets" && i + 1 < argc)
+			assets = argv[++i];
+		else if (!arg.starts_with("-"))
+			files.push_back(arg);
+		else
+		{
+			files.clear();
+			break;
+		}
+	}
+
+	if (files.empty())
+	{
+		LOG_ERROR("Usage: FractalRender [--assets <folder>] <jobs file>...");
+		return EXIT_FAILURE;
+	}
+
+	// All of them are read first, a typo should not show up hours in
+	std::vector<RenderJob> jobs;
+	try
+	{
+		for (const auto& file : files)
+		{
+			auto loaded = LoadJobs(file);
+			jobs.insert(jobs.end(), std::make_move_iterator(loaded.begin()), std::make_move_iterator(loaded.end()));
+		}
+	}
+	catch (const custom_error& e)
+	{
+		LOG_ERROR("{}", e.what());
+		return EXIT_FAILURE;
+	}
+
+	HeadlessContext context;
+
+	int failed = 0;
+	{
+		JobRunner runner(assets);
+		for (size_t i = 0; i < jobs.size(); i++)
+		{
+			LOG_INFO("[{}/{}] {}", i + 1, jobs.size(), jobs[i].output.string());
+			if (!runner.Run(jobs[i]))
+				failed++;
+		}
+	}
+
+	if (failed > 0)
+	{
+		LOG_ERROR("{} of {} jobs failed", failed, jobs.size());
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
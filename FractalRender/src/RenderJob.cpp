@@ -0,0 +1,188 @@
+#include "RenderJob.h"
+
+#include <fstream>
+#include <format>
+
+static std::string Trim(std::string_view text)
+{
+	const size_t first = text.find_first_not_of(" \t\r");
+	if (first == std::string_view::npos)
+		return {};
+
+	const size_t last = text.find_last_not_of(" \t\r");
+	return std::string(text.substr(first, last - first + 1));
+}
+
+template<typename T>
+static T Read(std::istringstream& value)
+{
+	T result;
+	value >> result;
+	if (value.fail())
+		throw custom_error(std::format("Invalid value '{}'", value.str()));
+	return result;
+}
+
+template<>
+bool Read<bool>(std::istringstream& value)
+{
+	const std::string text = Read<std::string>(value);
+	if (text == "true")
+		return true;
+	if (text == "false")
+		return false;
+	throw custom_error(std::format("Expected true or false, got '{}'", text));
+}
+
+// Keeps all the digits, which a double would round to about 16
+static BigFloat ReadBigFloat(std::istringstream& value)
+{
+	const std::string text = Read<std::string>(value);
+	std::optional<BigFloat> result = BigFloat::Parse(text);
+	if (!result)
+		throw custom_error(std::format("Invalid value '{}'", text));
+	return *result;
+}
+
+template<typename E>
+static E ReadEnum(std::istringstream& value, std::initializer_list<std::pair<std::string_view, E>> names)
+{
+	const std::string text = Read<std::string>(value);
+	for (const auto& [name, e] : names)
+	{
+		if (text == name)
+			return e;
+	}
+	throw custom_error(std::format("Unknown option '{}'", text));
+}
+
+static void ReadKey(RenderJob& job, const std::string& key, std::istringstream& value, int line)
+{
+	// Uniforms name theirs after the key, `uniform scale = 2`
+	std::istringstream keyWords(key);
+	std::string word, name;
+	keyWords >> word >> name;
+
+	if (word == "uniform" && !name.empty())
+		job.uniforms.push_back({ name, value.str(), line });
+	else if (word == "uniform_key" && !name.empty())
+	{
+		double t = Read<double>(value);
+		job.uniformKeys.push_back({ name, t, Read<float>(value) });
+	}
+	else if (key == "fractal")
+		job.fractal = Read<std::string>(value);
+	else if (key == "color")
+		job.color = Read<std::string>(value);
+	else if (key == "output")
+		job.output = Trim(value.str()); // May have spaces
+	else if (key == "resolution")
+		job.resolution = { Read<uint32_t>(value), Read<uint32_t>(value) };
+	else if (key == "center")
+		job.center = { ReadBigFloat(value), ReadBigFloat(value) };
+	else if (key == "radius")
+		job.radius = Read<double>(value);
+	else if (key == "julia_c")
+		job.juliaC = { Read<double>(value), Read<double>(value) };
+	else if (key == "set_color")
+		job.setColor = { Read<float>(value), Read<float>(value), Read<float>(value) };
+	else if (key == "steps")
+		job.steps = Read<int>(value);
+	else if (key == "iterations")
+		job.iterations = Read<int>(value);
+	else if (key == "max_epochs")
+		job.maxEpochs = Read<int>(value);
+	else if (key == "fade_threshold")
+		job.fadeThreshold = Read<int>(value);
+	else if (key == "exponent")
+		job.exponent = Read<int>(value);
+	else if (key == "smooth_color")
+		job.smoothColor = Read<bool>(value);
+	else if (key == "equalize")
+		job.equalize = Read<bool>(value);
+	else if (key == "perturbation")
+		job.perturbation = Read<bool>(value);
+	else if (key == "precision")
+		job.precision = ReadEnum<Precision>(value, { { "double", Precision::Double }, { "float-float", Precision::FloatFloat }, { "double-double", Precision::DoubleDouble } });
+	else if (key == "backend")
+		job.backend = ReadEnum<Backend>(value, { { "fragment", Backend::Fragment }, { "compute", Backend::Compute }, { "cpu", Backend::Cpu } });
+	else if (key == "render_mode")
+		job.renderMode = ReadEnum<RenderMode>(value, { { "full", RenderMode::Full }, { "guessing", RenderMode::Guessing } });
+	else if (key == "duration")
+		job.duration = Read<float>(value);
+	else if (key == "fps")
+		job.fps = Read<int>(value);
+	else if (key == "julia_amplitude")
+		job.juliaAmplitude = Read<double>(value);
+	else if (key == "radius_key")
+	{
+		double t = Read<double>(value);
+		job.radiusKeys.emplace_back(t, Read<double>(value));
+	}
+	else if (key == "center_key")
+	{
+		// The velocity is optional
+		double t = Read<double>(value);
+		CenterKey center = { { Read<double>(value), Read<double>(value) }, { 0.0, 0.0 } };
+		if (!(value >> std::ws).eof())
+			center.vel = { Read<double>(value), Read<double>(value) };
+		job.centerKeys.emplace_back(t, center);
+	}
+	else
+		throw custom_error(std::format("Unknown key '{}'", key));
+
+	if (!(value >> std::ws).eof() && word != "uniform" && key != "output")
+		throw custom_error(std::format("Too many values in '{}'", value.str()));
+}
+
+std::vector<RenderJob> LoadJobs(const std::filesystem::path& path)
+{
+	std::ifstream file(path);
+	if (!file)
+		throw custom_error(std::format("Could not open the job file '{}'", path.string()));
+
+	std::vector<RenderJob> jobs;
+	RenderJob defaults;
+	RenderJob* job = &defaults;
+
+	std::string text;
+	for (int line = 1; std::getline(file, text); line++)
+	{
+		text = Trim(text.substr(0, text.find('#')));
+		if (text.empty())
+			continue;
+
+		try
+		{
+			if (text.front() == '[')
+			{
+				if (text != "[still]" && text != "[video]")
+					throw custom_error(std::format("Unknown section '{}'", text));
+
+				job = &jobs.emplace_back(defaults);
+				job->type = text == "[still]" ? JobType::Still : JobType::Video;
+				job->line = line;
+				continue;
+			}
+
+			const size_t equal = text.find('=');
+			if (equal == std::string::npos)
+				throw custom_error("Expected 'key = value'");
+
+			std::istringstream value(Trim(text.substr(equal + 1)));
+			ReadKey(*job, Trim(text.substr(0, equal)), value, line);
+		}
+		catch (const custom_error& e)
+		{
+			throw custom_error(std::format("{}:{}: {}", path.string(), line, e.what()));
+		}
+	}
+
+	for (const RenderJob& j : jobs)
+	{
+		if (j.output.empty())
+			throw custom_error(std::format("{}:{}: The job has no output", path.string(), j.line));
+	}
+
+	return jobs;
+}
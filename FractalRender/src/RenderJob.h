@@ -0,0 +1,92 @@
+#pragma once
+
+#include <GLCore.h>
+
+#include <filesystem>
+
+#include "FractalVisualizer.h"
+#include "VideoRenderer.h"
+
+enum class JobType
+{
+	Still = 0,
+	Video
+};
+
+// Value of a color function uniform, written like in the job file and read
+// once the color function says which type it is
+struct UniformValue
+{
+	std::string name;
+	std::string value;
+	int line;
+};
+
+struct UniformKey
+{
+	std::string name;
+	double t;
+	float value;
+};
+
+// A still image or a video, see LoadJobs for the keys
+struct RenderJob
+{
+	JobType type = JobType::Still;
+	int line = 0; // Of its section in the job file
+
+	std::string fractal = "mandelbrot";
+	std::string color; // The default color function if empty
+	std::filesystem::path output;
+
+	glm::uvec2 resolution = { 1920, 1080 };
+	BigComplex center; // Keeps every digit of the file, for deep zooms
+	double radius = 1.0;
+	glm::dvec2 juliaC = { 0.0, 0.0 };
+	glm::vec3 setColor = { 0.f, 0.f, 0.f };
+
+	int steps = 100; // Of the image, or of every frame of a video
+	int iterations = 100; // Per step
+	int maxEpochs = 100;
+	int fadeThreshold = 0;
+	int exponent = 2;
+	bool smoothColor = true;
+	bool equalize = false;
+	bool perturbation = false;
+	Precision precision = Precision::Double;
+	Backend backend = Backend::Fragment;
+	RenderMode renderMode = RenderMode::Full;
+
+	std::vector<UniformValue> uniforms;
+
+	// Only for videos, the key frame times go from 0 to 1
+	float duration = 10.f;
+	int fps = 30;
+	double juliaAmplitude = 0.0;
+	std::vector<KeyFrame<double>> radiusKeys;
+	std::vector<KeyFrame<CenterKey>> centerKeys;
+	std::vector<UniformKey> uniformKeys;
+};
+
+// Reads the jobs of a file like:
+//
+//     # The keys before the first job are the defaults of all of them
+//     fractal = mandelbrot
+//     color = 3cycle
+//     resolution = 1920 1080
+//
+//     [still]
+//     output = overview.png
+//     center = -0.5 0
+//     radius = 1.3
+//     uniform scale = 2
+//
+//     [video]
+//     output = zoom.mp4
+//     duration = 10
+//     radius_key = 0 1.3
+//     radius_key = 1 1e-10
+//     center_key = 0 -0.743643887 0.131825904
+//
+// Throws custom_error pointing at the line that is wrong.
+std::vector<RenderJob> LoadJobs(const std::filesystem::path& path);
@@ -0,0 +1,40 @@
+-- Checks of the parts that run without a window, returns nonzero on failure
+project "FractalTests"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++20"
+	staticruntime "on"
+
+	targetdir ("../bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("../bin-int/" .. outputdir .. "/%{prj.name}")
+
+	files {
+		"src/**.h",
+		"src/**.cpp",
+		"../FractalVisualizer/src/BigFloat.h",
+		"../FractalVisualizer/src/BigFloat.cpp"
+	}
+
+	includedirs {
+		"../OpenGL-Core/vendor/spdlog/include",
+		"../OpenGL-Core/src",
+		"../OpenGL-Core/vendor",
+		"../OpenGL-Core/vendor/glm",
+		"../OpenGL-Core/vendor/Glad/include",
+		"../OpenGL-Core/vendor/imgui",
+		"../FractalVisualizer/src"
+	}
+
+	links {
+		"OpenGL-Core"
+	}
+
+	filter "configurations:Debug"
+		defines "GLCORE_DEBUG"
+		runtime "Debug"
+		symbols "on"
+
+	filter "configurations:Release"
+		defines "GLCORE_RELEASE"
+		runtime "Release"
+		optimize "on"
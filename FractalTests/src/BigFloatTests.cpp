@@ -0,0 +1,80 @@
+#include "BigFloat.h"
+
+#include <cmath>
+#include <cstdio>
+
+static int s_Failures = 0;
+
+static void ExpectNear(const char* what, double got, double expected)
+{
+	if (std::abs(got - expected) <= std::abs(expected) * 1e-12)
+		return;
+
+	std::printf("FAILED %s: got %.17g, expected %.17g\n", what, got, expected);
+	s_Failures++;
+}
+
+// The offsets of deep zooms are the difference of two close centers
+static void TinyDifferences()
+{
+	for (double delta : { 1e-10, 1e-30, 1e-100, 1e-200 })
+	{
+		const int limbs = BigFloat::LimbsForPixelSize(delta);
+		const BigFloat center(-0.75, limbs);
+		const BigFloat moved = center + BigFloat(delta, limbs);
+
+		char what[64];
+		std::snprintf(what, sizeof(what), "(c + %g) - c", delta);
+		ExpectNear(what, (moved - center).ToDouble(), delta);
+
+		std::snprintf(what, sizeof(what), "c - (c + %g)", delta);
+		ExpectNear(what, (center - moved).ToDouble(), -delta);
+	}
+}
+
+static void RoundTrip()
+{
+	for (double v : { 0.0, 1.0, -2.5, 0.1, 3e-25, -7.123456789e-150 })
+	{
+		char what[64];
+		std::snprintf(what, sizeof(what), "round trip of %g", v);
+		ExpectNear(what, BigFloat(v, BigFloat::LimbsForPixelSize(1e-160)).ToDouble(), v);
+	}
+}
+
+// The centers of job files keep more digits than a double
+static void ParseDigits()
+{
+	const auto a = BigFloat::Parse("-0.743643887037158704752191506114774");
+	const auto b = BigFloat::Parse("-0.743643887037158704752191506114775");
+	if (!a || !b)
+	{
+		std::printf("FAILED parsing the centers\n");
+		s_Failures++;
+		return;
+	}
+	ExpectNear("difference of parsed centers", (*b - *a).ToDouble(), -1e-33);
+
+	ExpectNear("parse of 1e-200", BigFloat::Parse("1e-200")->ToDouble(), 1e-200);
+	ExpectNear("parse of +2.25E+1", BigFloat::Parse("+2.25E+1")->ToDouble(), 22.5);
+
+	for (const char* text : { "", "-", "abc", "1.2.3", "5e", "4294967296" })
+	{
+		if (BigFloat::Parse(text))
+		{
+			std::printf("FAILED '%s' parsed as a number\n", text);
+			s_Failures++;
+		}
+	}
+}
+
+int main()
+{
+	TinyDifferences();
+	RoundTrip();
+	ParseDigits();
+
+	if (s_Failures == 0)
+		std::printf("All BigFloat tests passed\n");
+	return s_Failures == 0 ? 0 : 1;
+}
@@ -1,26 +1,102 @@
 #version 400 core
 
-layout (location = 0) out vec4 o_Color;
+#ifdef COMPUTE_BACKEND
+layout (local_size_x = LOCAL_SIZE) in;
+
+// Pixels that still have work left, see ActivePixelList
+layout (std430, binding = 0) readonly buffer ActivePixels
+{
+    uvec3 i_DispatchArgs;
+    uint i_ActiveCount;
+    uint i_Active[];
+};
+
+// The state is updated in place, see the main at the end of the file
+layout (rgba32f) uniform image2D i_Samples;
+layout (rgba32ui) uniform uimage2D i_Data;
+layout (rgba32ui) uniform uimage2D i_Iter;
+
+vec4 o_Samples;
+uvec4 o_Data;
+uvec4 o_Iter;
+
+#ifdef DOUBLE_DOUBLE
+layout (rgba32ui) uniform uimage2D i_DataLo;
+uvec4 o_DataLo;
+#endif
+
+#ifndef PERTURBATION
+layout (rgba32ui) uniform uimage2D i_Saved;
+uvec4 o_Saved;
+#endif
+
+vec4 frag_coord;
+#define LOAD(image) imageLoad(image, ivec2(frag_coord.xy))
+#define main fractal_main
+#else
+// Color index of the samples that escaped, see add_sample
+layout (location = 0) out vec4 o_Samples;
 
 layout (location = 1) out uvec4 o_Data;
-layout (location = 2) out uvec2 o_Iter;
+layout (location = 2) out uvec4 o_Iter;
+
+#ifdef DOUBLE_DOUBLE
+// Low parts of z
+layout (location = 3) out uvec4 o_DataLo;
+#endif
 
+#ifndef PERTURBATION
+// z saved by the periodicity check
+layout (location = 4) out uvec4 o_Saved;
+#endif
+
+uniform sampler2D i_Samples;
 uniform usampler2D i_Data;
 uniform usampler2D i_Iter;
 
-uniform uvec2 i_Size;
-uniform dvec2 i_xRange;
-uniform dvec2 i_yRange;
-uniform uint i_ItersPerFrame;
-uniform vec3 i_SetColor;
-uniform uint i_Frame;
-uniform uint i_MaxEpochs;
-uniform uint i_FadeThreshold;
-uniform bool i_SmoothColor;
+#ifdef DOUBLE_DOUBLE
+uniform usampler2D i_DataLo;
+#endif
+
+#ifndef PERTURBATION
+uniform usampler2D i_Saved;
+#endif
+
+#define frag_coord gl_FragCoord
+#define LOAD(sampler) texture(sampler, gl_FragCoord.xy / i_Size)
+#endif
 
-uniform uint i_EqExp;
+#ifdef PERTURBATION
+// Reference orbit as raw double bits, see FractalVisualizer::UpdateReference
+uniform usamplerBuffer i_RefOrbit;
+#endif
 
-#color
+uniform uint i_Frame;
+
+// Only uploaded when a value changes, see FractalVisualizer::UpdateParams
+layout (std140) uniform FractalParams
+{
+    dvec2 i_xRange;
+    dvec2 i_yRange;
+    dvec2 i_JuliaC;
+    dvec2 i_RefOffset;
+    dvec2 i_SeriesA;
+    dvec2 i_SeriesB;
+    dvec2 i_SeriesC;
+    dvec2 i_Center;
+    dvec2 i_CenterLo;
+    double i_PixelSize;
+    double i_SeriesScale;
+    vec4 i_CenterFF;
+    uvec2 i_Size;
+    uint i_ItersPerFrame;
+    uint i_MaxEpochs;
+    uint i_FadeThreshold;
+    uint i_RefLength;
+    uint i_SeriesSkip;
+    uint i_GuessTile;
+    uint i_ResolutionStride;
+};
 
 double map(double value, double inputMin, double inputMax, double outputMin, double outputMax)
 {
@@ -29,7 +105,7 @@ double map(double value, double inputMin, double inputMax, double outputMin, dou
 
 double rand(float s)
 {
-    return fract(sin(s * 12.9898) * 43758.5453);
+    return double(fract(sin(s * 12.9898) * 43758.5453));
 }
 
 dvec2 mul(dvec2 a, dvec2 b)
@@ -37,92 +113,672 @@ dvec2 mul(dvec2 a, dvec2 b)
     return dvec2(a.x*b.x-a.y*b.y, a.x*b.y+a.y*b.x);
 }
 
-dvec2 mandelbrot(dvec2 z, dvec2 c)
+// The exponent, EQ_EXP, is baked in by FractalVisualizer::CompileShader along
+// with SMOOTH_COLOR, FADE and LIMIT_EPOCHS for the features that are on
+
+// Three multiplies instead of the four of `mul`
+dvec2 sqr(dvec2 z)
+{
+    return dvec2((z.x + z.y) * (z.x - z.y), 2.0 * z.x * z.y);
+}
+
+// Binary exponentiation, unrolled by the compiler since EQ_EXP is a constant
+dvec2 cpow(dvec2 z)
 {
+#if EQ_EXP == 2
+    return sqr(z);
+#else
     dvec2 res = z;
-    for (uint i = 0; i < i_EqExp - 1; i++)
-        res = mul(res, z);
-    return res + c;
+    bool first = true;
+    for (uint e = EQ_EXP; e > 0; e >>= 1)
+    {
+        if ((e & 1u) != 0)
+        {
+            res = first ? z : mul(res, z);
+            first = false;
+        }
+        if (e > 1)
+            z = sqr(z);
+    }
+    return res;
+#endif
+}
+
+dvec2 mandelbrot(dvec2 z, dvec2 c)
+{
+    return cpow(z) + c;
+}
+
+// Color index and weight of a sample that escaped after `n` iterations. The
+// weight is the alpha its color would have been blended with.
+vec2 escape_sample(dvec2 z, uint epoch, int n)
+{
+#ifdef FADE
+    if (n > i_FadeThreshold)
+        epoch += int(float(n) / float(i_FadeThreshold));
+#endif
+
+    float index = float(n);
+#ifdef SMOOTH_COLOR
+    float log_zn = log(float(z.x*z.x + z.y*z.y)) / 2.0;
+    float nu = log(log_zn / log(2.0)) / log(float(EQ_EXP));
+
+    index = n + 1 - nu + 1.3;
+#endif
+
+    return vec2(index, 1.0 / float(epoch + 1));
+}
+
+// The colors are only picked by the resolve pass, see ColorResolve. Every pixel
+// keeps the weighted mean and variance of the color index of its samples and
+// how much of it they cover, the same weights blending their colors would give.
+vec4 add_sample(vec4 samples, vec2 escaped)
+{
+    float coverage = mix(samples.z, 1.0, escaped.y);
+    float weight = escaped.y / coverage;
+
+    float d = escaped.x - samples.x;
+    return vec4(samples.x + weight * d, (1.0 - weight) * (samples.y + weight * d * d), coverage, 0.0);
+}
+
+// Whether the pixel took all its samples, always false without a limit
+bool epochs_done(uint epoch)
+{
+#ifdef LIMIT_EPOCHS
+    return epoch >= i_MaxEpochs;
+#else
+    return false;
+#endif
+}
+
+// Flags in the w component of the iteration state, see MarianiSilver.cpp
+#define PIXEL_INTERIOR 1u // Found to be inside the set
+#define PIXEL_PENDING 2u  // Waiting to be guessed or computed
+#define PIXEL_GUESSED 4u  // Filled from the border of its tile
+#define PIXEL_START 8u    // To be computed from the next step on
+#define PIXEL_COARSE 16u  // Off the grid of the current resolution
+
+// With dynamic resolution only every i_ResolutionStride-th pixel is computed,
+// the rest keep waiting until the stride gets down to them
+bool on_resolution_grid()
+{
+    return all(equal(uvec2(frag_coord.xy) % i_ResolutionStride, uvec2(0)));
+}
+
+// Pixels start on the first step, when a pan exposes them and when the
+// resolution reaches them
+bool starts(uint flags)
+{
+    return i_Frame == 0 || flags == PIXEL_START || (flags == PIXEL_COARSE && on_resolution_grid());
+}
+
+// The pixels reached by the resolution keep the samples of their block until
+// they escape or are found to be inside. The perturbation kernel can not tell
+// the latter, so there they start from the set color.
+vec4 start_samples(uint flags)
+{
+    return flags == PIXEL_COARSE ? LOAD(i_Samples) : vec4(0.0);
+}
+
+#ifndef PERTURBATION
+
+// With guessing only the grid of the coarsest tiles is computed at first
+uint initial_flags()
+{
+    if (i_GuessTile == 0)
+        return 0u;
+
+    uvec2 p = uvec2(frag_coord.xy);
+    bool on_grid = any(equal(p % i_GuessTile, uvec2(0))) || any(equal(p, i_Size - 1));
+    return on_grid ? 0u : PIXEL_PENDING;
+}
+
+// Squared distance under which two points of an orbit are taken as the same
+double period_eps2()
+{
+    double eps = 1e-3 * i_PixelSize;
+    return eps * eps;
+}
+
+// Brent's cycle detection: z is saved at every power of two iteration and the
+// next ones are compared to it, so a cycle is caught once the window is longer
+// than its period. Orbits caught by an attracting cycle never escape.
+bool is_periodic(dvec2 z, inout dvec2 saved, uint n)
+{
+    if ((n & (n - 1)) == 0)
+    {
+        saved = z;
+        return false;
+    }
+
+    dvec2 d = z - saved;
+    return d.x*d.x + d.y*d.y < period_eps2();
+}
+
+dvec2 load_saved()
+{
+    uvec4 data = LOAD(i_Saved);
+    return dvec2(packDouble2x32(data.xy), packDouble2x32(data.zw));
+}
+
+void store_saved(dvec2 saved)
+{
+    o_Saved = uvec4(unpackDouble2x32(saved.x), unpackDouble2x32(saved.y));
+}
+
+// Main cardioid and period 2 bulb, only known for z^2 + c. c is rounded to a
+// double here, so the test is skipped when that is not well below a pixel.
+bool in_main_components(dvec2 c)
+{
+#if EQ_EXP != 2
+    return false;
+#else
+    if (i_PixelSize < 1e-14)
+        return false;
+
+    double x = c.x - 0.25;
+    double q = x*x + c.y*c.y;
+    if (q * (q + x) <= 0.25 * c.y*c.y)
+        return true;
+
+    return (c.x + 1.0)*(c.x + 1.0) + c.y*c.y <= 0.0625;
+#endif
+}
+#endif
+
+#if defined(FLOAT_FLOAT) || defined(DOUBLE_DOUBLE)
+// Each real is an unevaluated sum of two floats (or doubles), hi + lo, and
+// complex numbers are stored as (re.hi, re.lo, im.hi, im.lo)
+#ifdef FLOAT_FLOAT
+#define real float
+#define real2 vec2
+#define real4 vec4
+#define SPLITTER 4097.0 // 2^12 + 1
+#else
+#define real double
+#define real2 dvec2
+#define real4 dvec4
+#define SPLITTER 134217729.0lf // 2^27 + 1
+#endif
+
+// Error free transformations, `precise` keeps them from being optimized away
+real2 two_sum(real a, real b)
+{
+    precise real s = a + b;
+    precise real v = s - a;
+    precise real e = (a - (s - v)) + (b - v);
+    return real2(s, e);
+}
+
+real2 quick_two_sum(real a, real b)
+{
+    precise real s = a + b;
+    precise real e = b - (s - a);
+    return real2(s, e);
+}
+
+// Dekker's split, `fma` is not fused everywhere
+real2 split(real a)
+{
+    precise real t = SPLITTER * a;
+    precise real hi = t - (t - a);
+    precise real lo = a - hi;
+    return real2(hi, lo);
+}
+
+real2 two_prod(real a, real b)
+{
+    real2 as = split(a);
+    real2 bs = split(b);
+    precise real p = a * b;
+    precise real e = ((as.x * bs.x - p) + as.x * bs.y + as.y * bs.x) + as.y * bs.y;
+    return real2(p, e);
+}
+
+real2 x_add(real2 a, real2 b)
+{
+    real2 s = two_sum(a.x, b.x);
+    return quick_two_sum(s.x, s.y + a.y + b.y);
+}
+
+real2 x_mul(real2 a, real2 b)
+{
+    real2 p = two_prod(a.x, b.x);
+    return quick_two_sum(p.x, p.y + a.x*b.y + a.y*b.x);
+}
+
+real2 x_from_double(double d)
+{
+    real hi = real(d);
+    return real2(hi, real(d - hi));
+}
+
+real4 x_cmul(real4 a, real4 b)
+{
+    return real4(
+        x_add(x_mul(a.xy, b.xy), -x_mul(a.zw, b.zw)),
+        x_add(x_mul(a.xy, b.zw), x_mul(a.zw, b.xy))
+    );
+}
+
+real4 x_cadd(real4 a, real4 b)
+{
+    return real4(x_add(a.xy, b.xy), x_add(a.zw, b.zw));
+}
+
+// Same as sqr, doubling is exact
+real4 x_csqr(real4 z)
+{
+    real2 re = x_mul(x_add(z.xy, z.zw), x_add(z.xy, -z.zw));
+    real2 im = x_mul(z.xy, z.zw);
+    return real4(re, im + im);
+}
+
+// Same as cpow
+real4 x_cpow(real4 z)
+{
+#if EQ_EXP == 2
+    return x_csqr(z);
+#else
+    real4 res = z;
+    bool first = true;
+    for (uint e = EQ_EXP; e > 0; e >>= 1)
+    {
+        if ((e & 1u) != 0)
+        {
+            res = first ? z : x_cmul(res, z);
+            first = false;
+        }
+        if (e > 1)
+            z = x_csqr(z);
+    }
+    return res;
+#endif
+}
+
+real4 x_mandelbrot(real4 z, real4 c)
+{
+    return x_cadd(x_cpow(z), c);
+}
+
+// Position of a sample, with the offset from the center only in single precision
+real4 x_coords(vec2 pos)
+{
+#ifdef FLOAT_FLOAT
+    real4 center = i_CenterFF;
+#else
+    real4 center = real4(i_Center.x, i_CenterLo.x, i_Center.y, i_CenterLo.y);
+#endif
+    real2 offset = (real2(pos) - real2(i_Size) / 2.0) * real(i_PixelSize);
+    return real4(x_add(center.xy, real2(offset.x, 0)), x_add(center.zw, real2(offset.y, 0)));
+}
+
+real4 x_load_z()
+{
+    uvec4 data = LOAD(i_Data);
+#ifdef FLOAT_FLOAT
+    return uintBitsToFloat(data);
+#else
+    uvec4 data_lo = LOAD(i_DataLo);
+    return real4(packDouble2x32(data.xy), packDouble2x32(data_lo.xy), packDouble2x32(data.zw), packDouble2x32(data_lo.zw));
+#endif
+}
+
+void x_store_z(real4 z)
+{
+#ifdef FLOAT_FLOAT
+    o_Data = floatBitsToUint(z);
+#else
+    o_Data = uvec4(unpackDouble2x32(z.x), unpackDouble2x32(z.z));
+    o_DataLo = uvec4(unpackDouble2x32(z.y), unpackDouble2x32(z.w));
+#endif
+}
+
+// Same as is_periodic. Double-double only keeps the high parts of the saved z,
+// so deep cycles are missed rather than caught wrongly.
+bool x_is_periodic(real4 z, inout real4 saved, uint n)
+{
+    if ((n & (n - 1)) == 0)
+    {
+#ifdef FLOAT_FLOAT
+        saved = z;
+#else
+        saved = real4(z.x, 0, z.z, 0);
+#endif
+        return false;
+    }
+
+    real4 d = x_cadd(z, -saved);
+    return d.x*d.x + d.z*d.z < period_eps2();
+}
+
+real4 x_load_saved()
+{
+    uvec4 data = LOAD(i_Saved);
+#ifdef FLOAT_FLOAT
+    return uintBitsToFloat(data);
+#else
+    return real4(packDouble2x32(data.xy), 0, packDouble2x32(data.zw), 0);
+#endif
+}
+
+void x_store_saved(real4 saved)
+{
+#ifdef FLOAT_FLOAT
+    o_Saved = floatBitsToUint(saved);
+#else
+    o_Saved = uvec4(unpackDouble2x32(saved.x), unpackDouble2x32(saved.z));
+#endif
+}
+#endif
+
+#ifdef PERTURBATION
+dvec2 ref_orbit(uint n)
+{
+    uvec4 data = texelFetch(i_RefOrbit, int(n));
+    return dvec2(packDouble2x32(data.xy), packDouble2x32(data.zw));
+}
+
+// z^p - Z^p without cancellation, where z = Z + dz
+dvec2 perturb(dvec2 Z, dvec2 z, dvec2 dz)
+{
+#if EQ_EXP == 2
+    return mul(dz, z + Z);
+#else
+    // s = z^(p-1) + z^(p-2) Z + ... + Z^(p-1)
+    dvec2 s = dvec2(1, 0);
+    dvec2 Zj = dvec2(1, 0);
+    for (uint j = 1; j < EQ_EXP; j++)
+    {
+        Zj = mul(Zj, Z);
+        s = mul(s, z) + Zj;
+    }
+    return mul(dz, s);
+#endif
+}
+
+// Delta after the first i_SeriesSkip iterations, shared by the whole view
+dvec2 series(dvec2 d)
+{
+    dvec2 u = d / i_SeriesScale;
+    return i_SeriesScale * mul(u, i_SeriesA + mul(u, i_SeriesB + mul(u, i_SeriesC)));
+}
+
+void main()
+{
+    // Outside information
+    vec4 samples;
+    dvec2 dz;
+    uint epoch;
+    uint iters;
+    uint ref_iter;
+    uvec4 iter_data = i_Frame == 0 ? uvec4(0) : LOAD(i_Iter);
+    if (starts(iter_data.w))
+    {
+        dz = dvec2(0, 0);
+        epoch = 0;
+        iters = 0;
+        ref_iter = 0;
+        samples = vec4(0.0);
+    }
+    else
+    {
+        samples = LOAD(i_Samples);
+        uvec4 data = LOAD(i_Data);
+        dz.x = packDouble2x32(data.xy);
+        dz.y = packDouble2x32(data.zw);
+
+        epoch = iter_data.x;
+        iters = iter_data.y;
+        ref_iter = iter_data.z;
+    }
+
+    // Left for when the resolution reaches the pixel
+    if (!on_resolution_grid())
+    {
+        o_Data = uvec4(0);
+        o_Iter = uvec4(0, 0, 0, PIXEL_COARSE);
+        o_Samples = samples;
+        return;
+    }
+
+    // Stop at max epochs
+    if (epochs_done(epoch))
+    {
+        o_Data = uvec4(unpackDouble2x32(dz.x), unpackDouble2x32(dz.y));
+        o_Iter = uvec4(epoch, iters, ref_iter, 0);
+        o_Samples = samples;
+        return;
+    }
+
+    // Set the offset of c from the reference
+    dvec2 pos = frag_coord.xy + dvec2(rand(epoch), rand(epoch + 1));
+    dvec2 dc = (pos - dvec2(i_Size) / 2.0) * i_PixelSize + i_RefOffset;
+
+    if (iters == 0)
+    {
+        dz = series(dc);
+        iters = i_SeriesSkip;
+        ref_iter = i_SeriesSkip;
+    }
+
+    // Calculate the iterations
+    int i;
+    dvec2 z = ref_orbit(ref_iter) + dz;
+    for (i = 0; i < i_ItersPerFrame && z.x*z.x + z.y*z.y <= 100.0; i++)
+    {
+        // Rebase when the orbit gets closer to the start of the reference
+        // than to the reference itself, or when the reference runs out
+        if (z.x*z.x + z.y*z.y < dz.x*dz.x + dz.y*dz.y || ref_iter + 1 >= i_RefLength)
+        {
+            dz = z;
+            ref_iter = 0;
+        }
+
+        dz = perturb(ref_orbit(ref_iter), z, dz) + dc;
+        ref_iter++;
+
+        z = ref_orbit(ref_iter) + dz;
+    }
+
+    // Output the data
+    if (i == i_ItersPerFrame)
+    {
+        o_Data = uvec4(unpackDouble2x32(dz.x), unpackDouble2x32(dz.y));
+        o_Iter = uvec4(epoch, iters + i, ref_iter, 0);
+        o_Samples = samples;
+    }
+    else
+    {
+        o_Data = uvec4(unpackDouble2x32(0), unpackDouble2x32(0));
+        o_Iter = uvec4(epoch + 1, 0, 0, 0);
+
+        o_Samples = add_sample(samples, escape_sample(z, epoch, int(iters) + i));
+    }
 }
+#elif defined(FLOAT_FLOAT) || defined(DOUBLE_DOUBLE)
+void main()
+{
+    // Outside information
+    vec4 samples;
+    real4 z;
+    real4 saved;
+    uint epoch;
+    uint iters;
+    uint first_escape;
+    uint flags;
+    uvec4 iter_data = i_Frame == 0 ? uvec4(0) : LOAD(i_Iter);
+    bool start = starts(iter_data.w);
+    if (start)
+    {
+        z = real4(0);
+        saved = real4(0);
+        epoch = 0;
+        iters = 0;
+        first_escape = 0;
+        flags = !on_resolution_grid() ? PIXEL_COARSE : i_Frame == 0 ? initial_flags() : 0;
+        samples = start_samples(iter_data.w);
+    }
+    else
+    {
+        samples = LOAD(i_Samples);
+        z = x_load_z();
+        saved = x_load_saved();
+
+        epoch = iter_data.x;
+        iters = iter_data.y;
+        first_escape = iter_data.z;
+        flags = iter_data.w;
+    }
+
+    // Stop at max epochs, if an earlier sample was found to be inside the set or
+    // while the pixel is left to the guessing or to a finer resolution
+    if (epochs_done(epoch) || flags != 0)
+    {
+        x_store_z(z);
+        x_store_saved(saved);
+        o_Iter = uvec4(epoch, iters, first_escape, flags);
+        o_Samples = samples;
+        return;
+    }
+
+    // Set c
+    vec2 pos = frag_coord.xy + vec2(rand(epoch), rand(epoch + 1));
+    real4 c = x_coords(pos);
+
+    bool interior = iters == 0 && in_main_components(dvec2(double(c.x) + double(c.y), double(c.z) + double(c.w)));
+
+    // Calculate the iterations
+    int i;
+    for (i = 0; i < i_ItersPerFrame && !interior && z.x*z.x + z.z*z.z <= 100.0; i++)
+    {
+        z = x_mandelbrot(z, c);
+        interior = x_is_periodic(z, saved, iters + i + 1);
+    }
+
+    // Output the data
+    if (i == i_ItersPerFrame || interior)
+    {
+        x_store_z(z);
+        x_store_saved(saved);
+        o_Iter = uvec4(epoch, iters + i, first_escape, interior ? PIXEL_INTERIOR : 0u);
+        o_Samples = interior && epoch == 0 ? vec4(0.0) : samples;
+    }
+    else
+    {
+        x_store_z(real4(0));
+        x_store_saved(saved);
+        o_Iter = uvec4(epoch + 1, 0, epoch == 0 ? iters + i : first_escape, 0);
 
+        o_Samples = add_sample(samples, escape_sample(dvec2(z.x, z.z), epoch, int(iters) + i));
+    }
+}
+#else
 void main()
 {
     // Outside information
-    vec4 clear_color = vec4(0.0, 0.0, 0.0, 0.0);
+    vec4 samples;
     dvec2 z;
+    dvec2 saved;
     uint epoch;
     uint iters;
-    if (i_Frame == 0)
+    uint first_escape;
+    uint flags;
+    uvec4 iter_data = i_Frame == 0 ? uvec4(0) : LOAD(i_Iter);
+    bool start = starts(iter_data.w);
+    if (start)
     {
         z = dvec2(0, 0);
+        saved = dvec2(0, 0);
         epoch = 0;
         iters = 0;
-        clear_color = vec4(i_SetColor, 1);
+        first_escape = 0;
+        flags = !on_resolution_grid() ? PIXEL_COARSE : i_Frame == 0 ? initial_flags() : 0;
+        samples = start_samples(iter_data.w);
     }
     else
     {
-        uvec4 data = texture(i_Data, gl_FragCoord.xy / i_Size);
+        samples = LOAD(i_Samples);
+        uvec4 data = LOAD(i_Data);
         z.x = packDouble2x32(data.xy);
         z.y = packDouble2x32(data.zw);
+        saved = load_saved();
 
-        uvec2 iter_data = texture(i_Iter, gl_FragCoord.xy / i_Size).xy;
         epoch = iter_data.x;
         iters = iter_data.y;
+        first_escape = iter_data.z;
+        flags = iter_data.w;
     }
     
-    // Stop at max epochs
-    if (epoch >= i_MaxEpochs && i_MaxEpochs > 0)
+    // Stop at max epochs, if an earlier sample was found to be inside the set or
+    // while the pixel is left to the guessing or to a finer resolution
+    if (epochs_done(epoch) || flags != 0)
     {
         o_Data = uvec4(unpackDouble2x32(z.x), unpackDouble2x32(z.y));
-        o_Iter = uvec2(epoch, iters);
-        o_Color = vec4(0.0, 0.0, 0.0, 0.0);
+        o_Iter = uvec4(epoch, iters, first_escape, flags);
+        store_saved(saved);
+        o_Samples = samples;
         return;
     }
 
     // Set c
     dvec2 c;
-    dvec2 pos = gl_FragCoord.xy + dvec2(rand(epoch), rand(epoch + 1));
+    dvec2 pos = frag_coord.xy + dvec2(rand(epoch), rand(epoch + 1));
     c.x = map(pos.x, 0, i_Size.x, i_xRange.x, i_xRange.y);
     c.y = map(pos.y, 0, i_Size.y, i_yRange.x, i_yRange.y);
 
+    bool interior = iters == 0 && in_main_components(c);
+
     // Calculate the iterations
     int i;
-    for (i = 0; i < i_ItersPerFrame && z.x*z.x + z.y*z.y <= 100.0; i++)
+    for (i = 0; i < i_ItersPerFrame && !interior && z.x*z.x + z.y*z.y <= 100.0; i++)
     {
         z = mandelbrot(z, c);
+        interior = is_periodic(z, saved, iters + i + 1);
     }
 
     // Output the data
-    if (i == i_ItersPerFrame)
+    if (i == i_ItersPerFrame || interior)
     {
         o_Data = uvec4(unpackDouble2x32(z.x), unpackDouble2x32(z.y));
-        o_Iter = uvec2(epoch, iters + i);
-        o_Color = clear_color;
+        o_Iter = uvec4(epoch, iters + i, first_escape, interior ? PIXEL_INTERIOR : 0u);
+        store_saved(saved);
+        o_Samples = interior && epoch == 0 ? vec4(0.0) : samples;
     }
     else
     {
         o_Data = uvec4(unpackDouble2x32(0), unpackDouble2x32(0));
-        o_Iter = uvec2(epoch + 1, 0);
-
-        vec3 color;
-        int n = int(iters) + i;
-        
-        if (i_FadeThreshold > 0 && n > i_FadeThreshold)
-            epoch += int(float(n) / float(i_FadeThreshold));
+        o_Iter = uvec4(epoch + 1, 0, epoch == 0 ? iters + i : first_escape, 0);
+        store_saved(saved);
 
+        o_Samples = add_sample(samples, escape_sample(z, epoch, int(iters) + i));
+    }
+}
+#endif
 
-        if (i_SmoothColor)
-        {
-            float log_zn = log(float(z.x*z.x + z.y*z.y)) / 2.0;
-            float nu = log(log_zn / log(2.0)) / log(i_EqExp);
+#ifdef COMPUTE_BACKEND
+#undef main
+void main()
+{
+    // Dispatches can be split in two dimensions, see DispatchSize
+    uint index = (gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x) * gl_WorkGroupSize.x + gl_LocalInvocationID.x;
+    if (index >= i_ActiveCount)
+        return;
 
-            float new_iter = n + 1 - nu + 1.3;
+    uint pixel = i_Active[index];
+    ivec2 p = ivec2(pixel & 0xFFFFu, pixel >> 16);
+    frag_coord = vec4(vec2(p) + 0.5, 0.0, 1.0);
 
-            color = get_color(new_iter);
-        }
-        else
-            color = get_color(n);
+    fractal_main();
 
-        o_Color = vec4(color, 1.0 / float(epoch + 1));
-    }
-}
\ No newline at end of file
+    imageStore(i_Data, p, o_Data);
+    imageStore(i_Iter, p, o_Iter);
+#ifdef DOUBLE_DOUBLE
+    imageStore(i_DataLo, p, o_DataLo);
+#endif
+#ifndef PERTURBATION
+    imageStore(i_Saved, p, o_Saved);
+#endif
+    imageStore(i_Samples, p, o_Samples);
+}
+#endif
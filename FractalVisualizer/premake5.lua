@@ -34,6 +34,20 @@ project "FractalVisualizer"
 		"{COPYFILE} ./imgui.ini %{cfg.targetdir}/imgui.ini"
 	}
 
+	-- The CPU kernels of each instruction set, picked at runtime
+	filter "files:src/CpuKernelAVX2.cpp"
+		vectorextensions "AVX2"
+
+	filter { "files:src/CpuKernelAVX512.cpp", "toolset:msc*" }
+		buildoptions { "/arch:AVX512" }
+
+	filter { "files:src/CpuKernelAVX512.cpp", "toolset:not msc*" }
+		buildoptions { "-mavx512f", "-mavx512dq" }
+
+	-- No fused multiply-add, every kernel has to round like the shaders
+	filter { "files:src/CpuKernel*.cpp", "toolset:not msc*" }
+		buildoptions { "-ffp-contract=off" }
+
 	filter "system:windows"
 		systemversion "latest"
 
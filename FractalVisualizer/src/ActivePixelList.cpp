@@ -0,0 +1,237 @@
+#include "ActivePixelList.h"
+#include "ComputeShader.h"
+
+#include <format>
+
+// The three passes of the compaction, selected with a define:
+//  SCAN_PIXELS:  work group wide exclusive scan of the active flags
+//  SCAN_BLOCKS:  scan of the per work group totals, writes the dispatch arguments
+//  SCATTER:      writes every active pixel at its final position
+static const char* s_CompactionSrc = R"(
+layout (local_size_x = SCAN_GROUP_SIZE) in;
+
+layout (binding = 1, rgba32ui) readonly uniform uimage2D i_Iter;
+
+layout (location = 0) uniform uvec2 i_Size;
+layout (location = 1) uniform uint i_MaxEpochs;
+layout (location = 2) uniform uint i_GroupSize;
+layout (location = 3) uniform uint i_Blocks;
+layout (location = 4) uniform bool i_EveryPixel;
+
+layout (std430, binding = 0) buffer ActivePixels
+{
+    uvec3 dispatch_args;
+    uint active_count;
+    uint pixels[];
+};
+
+// Exclusive offset inside the work group, with the active flag in the top bit
+layout (std430, binding = 1) buffer Offsets
+{
+    uint offsets[];
+};
+
+layout (std430, binding = 2) buffer BlockSums
+{
+    uint block_sums[];
+};
+
+#define ACTIVE_BIT 0x80000000u
+
+// Interior, pending or guessed, see the flags in the fractal shaders
+#define DONE_FLAGS 7u
+
+shared uint s_Scan[SCAN_GROUP_SIZE];
+
+// Dispatches can be split in two dimensions, see DispatchSize
+uint linear_index()
+{
+    return (gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x) * SCAN_GROUP_SIZE + gl_LocalInvocationID.x;
+}
+
+// Inclusive scan over the work group, every invocation must call it
+uint group_scan(uint value)
+{
+    uint id = gl_LocalInvocationID.x;
+    s_Scan[id] = value;
+    barrier();
+
+    for (uint offset = 1; offset < SCAN_GROUP_SIZE; offset <<= 1)
+    {
+        uint other = id >= offset ? s_Scan[id - offset] : 0;
+        barrier();
+        s_Scan[id] += other;
+        barrier();
+    }
+
+    return s_Scan[id];
+}
+
+#if defined(SCAN_PIXELS)
+void main()
+{
+    uint index = linear_index();
+
+    bool is_active = false;
+    if (index < i_Size.x * i_Size.y)
+    {
+        ivec2 pos = ivec2(index % i_Size.x, index / i_Size.x);
+        uvec4 iter = i_EveryPixel ? uvec4(0) : imageLoad(i_Iter, pos);
+        is_active = (i_MaxEpochs == 0 || iter.x < i_MaxEpochs) && (iter.w & DONE_FLAGS) == 0;
+    }
+
+    uint flag = is_active ? 1 : 0;
+    uint sum = group_scan(flag);
+
+    if (index < i_Size.x * i_Size.y)
+        offsets[index] = (sum - flag) | (is_active ? ACTIVE_BIT : 0);
+
+    // Large sizes dispatch a 2D grid, its padding groups have no block
+    if (gl_LocalInvocationID.x == SCAN_GROUP_SIZE - 1 && index / SCAN_GROUP_SIZE < i_Blocks)
+        block_sums[index / SCAN_GROUP_SIZE] = sum;
+}
+#elif defined(SCAN_BLOCKS)
+void main()
+{
+    // A single work group, each invocation takes a contiguous chunk of blocks
+    uint chunk = (i_Blocks + SCAN_GROUP_SIZE - 1) / SCAN_GROUP_SIZE;
+    uint first = min(gl_LocalInvocationID.x * chunk, i_Blocks);
+    uint last = min(first + chunk, i_Blocks);
+
+    uint sum = 0;
+    for (uint b = first; b < last; b++)
+        sum += block_sums[b];
+
+    uint offset = group_scan(sum) - sum;
+    for (uint b = first; b < last; b++)
+    {
+        uint block = block_sums[b];
+        block_sums[b] = offset;
+        offset += block;
+    }
+
+    // The last chunk ends at the total
+    if (gl_LocalInvocationID.x == SCAN_GROUP_SIZE - 1)
+    {
+        active_count = offset;
+
+        // Same as DispatchSize
+        uint groups = (offset + i_GroupSize - 1) / i_GroupSize;
+        if (groups <= 65535)
+            dispatch_args = uvec3(groups, 1, 1);
+        else
+            dispatch_args = uvec3(65535, (groups + 65534) / 65535, 1);
+    }
+}
+#elif defined(SCATTER)
+void main()
+{
+    uint index = linear_index();
+    if (index >= i_Size.x * i_Size.y)
+        return;
+
+    uint offset = offsets[index];
+    if ((offset & ACTIVE_BIT) != 0)
+    {
+        uint pixel = (index % i_Size.x) | ((index / i_Size.x) << 16);
+        pixels[block_sums[index / SCAN_GROUP_SIZE] + (offset & ~ACTIVE_BIT)] = pixel;
+    }
+}
+#endif
+)";
+
+static GLuint CreatePass(const char* pass)
+{
+	std::string source = std::format("#version 430 core\n#define {}\n#define SCAN_GROUP_SIZE {}\n", pass, ActivePixelList::ScanGroupSize);
+	return CreateComputeShader(source + s_CompactionSrc);
+}
+
+ActivePixelList::ActivePixelList()
+{
+	m_ScanProgram = CreatePass("SCAN_PIXELS");
+	m_BlocksProgram = CreatePass("SCAN_BLOCKS");
+	m_ScatterProgram = CreatePass("SCATTER");
+
+	glGenBuffers(1, &m_ListBuffer);
+	glGenBuffers(1, &m_OffsetsBuffer);
+	glGenBuffers(1, &m_BlockSumsBuffer);
+}
+
+ActivePixelList::~ActivePixelList()
+{
+	glDeleteProgram(m_ScanProgram);
+	glDeleteProgram(m_BlocksProgram);
+	glDeleteProgram(m_ScatterProgram);
+
+	glDeleteBuffers(1, &m_ListBuffer);
+	glDeleteBuffers(1, &m_OffsetsBuffer);
+	glDeleteBuffers(1, &m_BlockSumsBuffer);
+}
+
+void ActivePixelList::Resize(const glm::uvec2& size)
+{
+	if (size == m_Size)
+		return;
+
+	m_Size = size;
+
+	const GLsizeiptr pixels = (GLsizeiptr)size.x * size.y;
+	m_Blocks = (uint32_t)((pixels + ScanGroupSize - 1) / ScanGroupSize);
+
+	// Dispatch arguments and count, then the pixels
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_ListBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, 4 * sizeof(uint32_t) + pixels * sizeof(uint32_t), nullptr, GL_DYNAMIC_COPY);
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_OffsetsBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, pixels * sizeof(uint32_t), nullptr, GL_DYNAMIC_COPY);
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_BlockSumsBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, m_Blocks * sizeof(uint32_t), nullptr, GL_DYNAMIC_COPY);
+}
+
+void ActivePixelList::Rebuild(uint32_t maxEpochs, uint32_t groupSize)
+{
+	Build(false, maxEpochs, groupSize);
+}
+
+void ActivePixelList::Fill(uint32_t groupSize)
+{
+	Build(true, 0, groupSize);
+}
+
+void ActivePixelList::Build(bool everyPixel, uint32_t maxEpochs, uint32_t groupSize)
+{
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_ListBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_OffsetsBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_BlockSumsBuffer);
+
+	const glm::uvec2 groups = DispatchSize(m_Blocks);
+
+	for (GLuint program : { m_ScanProgram, m_BlocksProgram, m_ScatterProgram })
+	{
+		glProgramUniform2ui(program, 0, m_Size.x, m_Size.y);
+		glProgramUniform1ui(program, 1, maxEpochs);
+		glProgramUniform1ui(program, 2, groupSize);
+		glProgramUniform1ui(program, 3, m_Blocks);
+		glProgramUniform1i(program, 4, everyPixel);
+	}
+
+	glUseProgram(m_ScanProgram);
+	glDispatchCompute(groups.x, groups.y, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+	glUseProgram(m_BlocksProgram);
+	glDispatchCompute(1, 1, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+	glUseProgram(m_ScatterProgram);
+	glDispatchCompute(groups.x, groups.y, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+}
+
+void ActivePixelList::Dispatch() const
+{
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, Binding, m_ListBuffer);
+	glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, m_ListBuffer);
+	glDispatchComputeIndirect(0);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <GLCore.h>
+
+// Compacted list of the pixels that still have work left, built on the GPU with
+// a prefix sum over the iteration state. The compute backend dispatches one
+// invocation per listed pixel, so finished pixels stop costing anything.
+//
+// The buffer bound at `Binding` holds the indirect dispatch arguments, the
+// number of active pixels and then the pixels packed as x | y << 16.
+class ActivePixelList
+{
+public:
+	ActivePixelList();
+	~ActivePixelList();
+
+	void Resize(const glm::uvec2& size);
+
+	// Lists the pixels of the iteration state bound to image unit `IterUnit`
+	// that are not interior, pending or guessed (w) and whose epoch (x) is
+	// below `maxEpochs`, if not 0. The dispatch arguments are written for work
+	// groups of `groupSize`.
+	void Rebuild(uint32_t maxEpochs, uint32_t groupSize);
+
+	// Lists every pixel, for when the iteration state is not valid yet
+	void Fill(uint32_t groupSize);
+
+	// Binds the list and dispatches the currently bound program over it
+	void Dispatch() const;
+
+	static constexpr GLuint Binding = 0;
+	static constexpr GLuint IterUnit = 1;
+
+	// Work group size of the compaction passes
+	static constexpr uint32_t ScanGroupSize = 256;
+
+private:
+	void Build(bool everyPixel, uint32_t maxEpochs, uint32_t groupSize);
+
+	GLuint m_ScanProgram = 0;
+	GLuint m_BlocksProgram = 0;
+	GLuint m_ScatterProgram = 0;
+
+	GLuint m_ListBuffer = 0;
+	GLuint m_OffsetsBuffer = 0;
+	GLuint m_BlockSumsBuffer = 0;
+
+	glm::uvec2 m_Size = { 0, 0 };
+	uint32_t m_Blocks = 0;
+};
@@ -0,0 +1,314 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <initializer_list>
+#include <span>
+#include <vector>
+
+template<typename T>
+struct KeyFrame
+{
+	KeyFrame(double t, T val) : t(t), val(val) {}
+	double t;
+	T val;
+};
+
+struct CenterKey
+{
+	glm::dvec2 pos;
+	glm::dvec2 vel;
+};
+
+// How a track goes from a key frame to the next
+enum class TrackSpace
+{
+	Linear = 0,
+	Log // Interpolates the log of the values, for scales such as the radius
+};
+
+// Segment between two key frames, in the time since the first one
+template<typename V>
+struct Cubic
+{
+	V a = V(0);
+	V b = V(0);
+	V c = V(0);
+	V d = V(0);
+
+	V operator()(double u) const { return V(((a * u + b) * u + c) * u + d); }
+	V Derivative(double u) const { return V((3.0 * a * u + 2.0 * b) * u + c); }
+};
+
+// Goes from p0 with the velocity v0 to p1 with v1 in `duration`
+template<typename V>
+Cubic<V> FitHermite(const V& p0, const V& p1, const V& v0, const V& v1, double duration)
+{
+	// Two key frames at the same time
+	if (duration <= 0.0)
+		return { V(0), V(0), V(0), p0 };
+
+	const double h = duration;
+	return {
+		V((2.0 * (p0 - p1) + h * (v0 + v1)) / (h * h * h)),
+		V(-(3.0 * (p0 - p1) + h * (2.0 * v0 + v1)) / (h * h)),
+		v0,
+		p0
+	};
+}
+
+// Scalars go through Catmull-Rom: the velocity of a key frame is the slope
+// between its neighbours, with a key mirrored past each end of the track.
+template<typename T>
+struct TrackTraits
+{
+	using Value = T;
+
+	static Value KeyValue(const T& key) { return key; }
+
+	static Value Output(const Value& v, TrackSpace space)
+	{
+		return space == TrackSpace::Log ? Value(std::exp(v)) : v;
+	}
+
+	static Cubic<Value> Fit(std::span<const double> t, std::span<const T> keys, size_t i, TrackSpace space)
+	{
+		auto value = [&](size_t k) { return space == TrackSpace::Log ? std::log((double)keys[k]) : (double)keys[k]; };
+
+		const double t1 = t[i];
+		const double t2 = t[i + 1];
+		const double v1 = value(i);
+		const double v2 = value(i + 1);
+
+		const bool first = i == 0;
+		const bool last = i + 2 == keys.size();
+		const double t0 = first ? 2.0 * t1 - t2 : t[i - 1];
+		const double v0 = first ? 2.0 * v1 - v2 : value(i - 1);
+		const double t3 = last ? 2.0 * t2 - t1 : t[i + 2];
+		const double v3 = last ? 2.0 * v2 - v1 : value(i + 2);
+
+		const Cubic<double> c = FitHermite(v1, v2, (v2 - v0) / (t2 - t0), (v3 - v1) / (t3 - t1), t2 - t1);
+		return { Value(c.a), Value(c.b), Value(c.c), Value(c.d) };
+	}
+};
+
+// The center goes through the velocities of its key frames
+template<>
+struct TrackTraits<CenterKey>
+{
+	using Value = glm::dvec2;
+
+	static Value KeyValue(const CenterKey& key) { return key.pos; }
+
+	static Value Output(const Value& v, TrackSpace) { return v; }
+
+	static Cubic<Value> Fit(std::span<const double> t, std::span<const CenterKey> keys, size_t i, TrackSpace)
+	{
+		return FitHermite(keys[i].pos, keys[i + 1].pos, keys[i].vel, keys[i + 1].vel, t[i + 1] - t[i]);
+	}
+};
+
+// The key frames of an animated value, sorted by time. The times and the
+// values are stored apart, and the cubic of every segment is fitted as the
+// keys change. An edit only refits the segments whose shape depends on the
+// keys it touched, so evaluating is a search and a polynomial.
+template<typename T>
+class AnimationTrack
+{
+public:
+	using Traits = TrackTraits<T>;
+	using Value = typename Traits::Value;
+
+	AnimationTrack(TrackSpace space = TrackSpace::Linear)
+		: m_Space(space)
+	{
+	}
+
+	AnimationTrack(std::initializer_list<KeyFrame<T>> keys, TrackSpace space = TrackSpace::Linear)
+		: m_Space(space)
+	{
+		for (const KeyFrame<T>& key : keys)
+			Insert(key.t, key.val);
+	}
+
+	size_t Size() const { return m_Times.size(); }
+	bool Empty() const { return m_Times.empty(); }
+
+	double GetTime(size_t i) const { return m_Times[i]; }
+	const T& GetValue(size_t i) const { return m_Values[i]; }
+
+	// Stays the same when the key moves, for the ids of the UI
+	uint32_t GetId(size_t i) const { return m_Ids[i]; }
+
+	const std::vector<double>& GetTimes() const { return m_Times; }
+	const std::vector<T>& GetValues() const { return m_Values; }
+
+	size_t GetSegmentCount() const { return m_Segments.size(); }
+	const Cubic<Value>& GetSegment(size_t i) const { return m_Segments[i]; }
+
+	// Changes whenever the segment is fitted again, and is the same for all
+	// the copies of a fit. Lets the data derived from a segment be kept.
+	uint64_t GetRevision(size_t i) const { return m_Revisions[i]; }
+
+	// After the keys at the same time, returns its index
+	size_t Insert(double t, const T& val)
+	{
+		return Insert(t, val, m_NextId++);
+	}
+
+	void Erase(size_t i)
+	{
+		assert(i < Size());
+
+		if (!m_Segments.empty())
+		{
+			const size_t segment = std::min(i, m_Segments.size() - 1);
+			m_Segments.erase(m_Segments.begin() + segment);
+			m_Revisions.erase(m_Revisions.begin() + segment);
+		}
+
+		m_Times.erase(m_Times.begin() + i);
+		m_Values.erase(m_Values.begin() + i);
+		m_Ids.erase(m_Ids.begin() + i);
+
+		// The keys around it are now neighbours
+		if (!Empty())
+			Refit(std::min(i, Size() - 1));
+	}
+
+	void Clear()
+	{
+		m_Times.clear();
+		m_Values.clear();
+		m_Ids.clear();
+		m_Segments.clear();
+		m_Revisions.clear();
+	}
+
+	void SetValue(size_t i, const T& val)
+	{
+		m_Values[i] = val;
+		Refit(i);
+	}
+
+	// Moves the key to its place in time, returns its new index
+	size_t SetTime(size_t i, double t)
+	{
+		if ((i == 0 || m_Times[i - 1] <= t) && (i + 1 == Size() || t <= m_Times[i + 1]))
+		{
+			m_Times[i] = t;
+			Refit(i);
+			return i;
+		}
+
+		const T val = m_Values[i];
+		const uint32_t id = m_Ids[i];
+		Erase(i);
+		return Insert(t, val, id);
+	}
+
+	// The segment that contains t, or the one at that end
+	size_t FindSegment(double t) const
+	{
+		assert(!m_Segments.empty());
+
+		const size_t i = std::upper_bound(m_Times.begin(), m_Times.end(), t) - m_Times.begin();
+		return std::clamp(i, (size_t)1, m_Segments.size()) - 1;
+	}
+
+	Value Evaluate(double t) const
+	{
+		assert(!Empty());
+
+		if (t <= m_Times.front())
+			return Traits::KeyValue(m_Values.front());
+
+		if (t >= m_Times.back())
+			return Traits::KeyValue(m_Values.back());
+
+		const size_t i = FindSegment(t);
+		return Traits::Output(m_Segments[i](t - m_Times[i]), m_Space);
+	}
+
+	// Evaluates every t. When they are sorted the segments are walked
+	// instead of searched.
+	void Evaluate(std::span<const double> t, std::span<Value> out) const
+	{
+		assert(!Empty() && t.size() == out.size());
+
+		size_t i = 0;
+		for (size_t k = 0; k < t.size(); k++)
+		{
+			const double x = t[k];
+			if (x <= m_Times.front())
+			{
+				out[k] = Traits::KeyValue(m_Values.front());
+				continue;
+			}
+			if (x >= m_Times.back())
+			{
+				out[k] = Traits::KeyValue(m_Values.back());
+				continue;
+			}
+
+			if (x < m_Times[i] || m_Times[i + 1] <= x)
+			{
+				if (m_Times[i + 1] <= x && x < m_Times[i + 2])
+					i++;
+				else
+					i = FindSegment(x);
+			}
+			out[k] = Traits::Output(m_Segments[i](x - m_Times[i]), m_Space);
+		}
+	}
+
+private:
+	size_t Insert(double t, const T& val, uint32_t id)
+	{
+		const size_t i = std::upper_bound(m_Times.begin(), m_Times.end(), t) - m_Times.begin();
+
+		// Takes the place of the segment it splits
+		if (!Empty())
+		{
+			const size_t segment = std::min(i, m_Segments.size());
+			m_Segments.insert(m_Segments.begin() + segment, Cubic<Value>());
+			m_Revisions.insert(m_Revisions.begin() + segment, 0);
+		}
+
+		m_Times.insert(m_Times.begin() + i, t);
+		m_Values.insert(m_Values.begin() + i, val);
+		m_Ids.insert(m_Ids.begin() + i, id);
+
+		Refit(i);
+		return i;
+	}
+
+	// The velocities of the keys next to the one at i depend on it, so it
+	// shapes the two segments at each side
+	void Refit(size_t i)
+	{
+		const size_t first = i < 2 ? 0 : i - 2;
+		const size_t last = std::min(i + 2, m_Segments.size());
+		for (size_t segment = first; segment < last; segment++)
+		{
+			m_Segments[segment] = Traits::Fit(m_Times, m_Values, segment, m_Space);
+			m_Revisions[segment] = s_NextRevision++;
+		}
+	}
+
+	std::vector<double> m_Times;
+	std::vector<T> m_Values;
+	std::vector<uint32_t> m_Ids;
+
+	std::vector<Cubic<Value>> m_Segments;
+	std::vector<uint64_t> m_Revisions;
+
+	TrackSpace m_Space;
+	uint32_t m_NextId = 0;
+
+	inline static std::atomic<uint64_t> s_NextRevision{ 1 };
+};
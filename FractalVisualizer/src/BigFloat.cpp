@@ -0,0 +1,253 @@
+#include "BigFloat.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <string>
+
+BigFloat::BigFloat(double value, int limbs)
+	: m_Negative(value < 0.0), m_Limbs(std::max(limbs, 1), 0)
+{
+	double v = std::abs(value);
+	for (size_t i = 0; i < m_Limbs.size() && v != 0.0; i++)
+	{
+		double limb = std::floor(v);
+		m_Limbs[i] = (uint32_t)limb;
+		v = (v - limb) * 4294967296.0;
+	}
+}
+
+int BigFloat::LimbsForPixelSize(double pixelSize)
+{
+	int bits = (int)std::ceil(-std::log2(pixelSize)) + 64;
+	return std::max(MinLimbs, 1 + (bits + 31) / 32);
+}
+
+std::optional<BigFloat> BigFloat::Parse(std::string_view text)
+{
+	size_t i = 0;
+	const bool negative = i < text.size() && text[i] == '-';
+	if (i < text.size() && (text[i] == '-' || text[i] == '+'))
+		i++;
+
+	// All the digits, and how many of them go before the point
+	std::string digits;
+	int point = -1;
+	for (; i < text.size(); i++)
+	{
+		if (std::isdigit((unsigned char)text[i]))
+			digits += text[i];
+		else if (text[i] == '.' && point < 0)
+			point = (int)digits.size();
+		else
+			break;
+	}
+	if (digits.empty())
+		return std::nullopt;
+	if (point < 0)
+		point = (int)digits.size();
+
+	if (i < text.size() && (text[i] == 'e' || text[i] == 'E'))
+	{
+		// from_chars does not take a plus sign
+		i++;
+		if (i < text.size() && text[i] == '+')
+			i++;
+
+		int exponent = 0;
+		auto [end, error] = std::from_chars(text.data() + i, text.data() + text.size(), exponent);
+		if (error != std::errc() || std::abs(exponent) > 10000)
+			return std::nullopt;
+
+		point += exponent;
+		i = end - text.data();
+	}
+	if (i != text.size())
+		return std::nullopt;
+
+	// Shifts the point into the digits
+	if (point < 0)
+	{
+		digits.insert(0, -point, '0');
+		point = 0;
+	}
+	if (point > (int)digits.size())
+		digits.append(point - digits.size(), '0');
+
+	uint64_t integer = 0;
+	for (int k = 0; k < point; k++)
+	{
+		integer = integer * 10 + (digits[k] - '0');
+		if (integer > UINT32_MAX)
+			return std::nullopt;
+	}
+
+	// Every decimal digit is log2(10) bits, the last one also gets some guard
+	// bits like LimbsForPixelSize
+	std::string fraction = digits.substr(point);
+	const int bits = (int)std::ceil(fraction.size() * 3.3219280948873623) + 64;
+	BigFloat r(0.0, std::max(MinLimbs, 1 + (bits + 31) / 32));
+	r.m_Limbs[0] = (uint32_t)integer;
+
+	// Multiplying the fraction by 2^32 carries the next limb out of it
+	for (size_t l = 1; l < r.m_Limbs.size(); l++)
+	{
+		uint64_t carry = 0;
+		for (size_t k = fraction.size(); k-- > 0;)
+		{
+			const uint64_t d = (uint64_t)(fraction[k] - '0') * 4294967296ull + carry;
+			fraction[k] = (char)('0' + d % 10);
+			carry = d / 10;
+		}
+		r.m_Limbs[l] = (uint32_t)carry;
+	}
+
+	r.m_Negative = negative && !r.IsZero();
+	return r;
+}
+
+void BigFloat::SetPrecision(int limbs)
+{
+	m_Limbs.resize(std::max(limbs, 1), 0);
+}
+
+double BigFloat::ToDouble() const
+{
+	// Deep zoom offsets start many limbs down, so it reads from the first
+	// nonzero one. Three limbs already hold more bits than a double.
+	auto first = std::ranges::find_if(m_Limbs, [](uint32_t l) { return l != 0; });
+	if (first == m_Limbs.end())
+		return 0.0;
+
+	const size_t start = first - m_Limbs.begin();
+	double v = 0.0;
+	double scale = 1.0;
+	for (size_t i = start; i < m_Limbs.size() && i < start + 3; i++)
+	{
+		v += m_Limbs[i] * scale;
+		scale /= 4294967296.0;
+	}
+	v = std::ldexp(v, -32 * (int)start);
+	return m_Negative ? -v : v;
+}
+
+bool BigFloat::IsZero() const
+{
+	return std::ranges::all_of(m_Limbs, [](uint32_t l) { return l == 0; });
+}
+
+BigFloat BigFloat::operator-() const
+{
+	BigFloat r = *this;
+	r.m_Negative = !m_Negative;
+	return r;
+}
+
+int BigFloat::CompareMagnitude(const BigFloat& a, const BigFloat& b)
+{
+	size_t n = std::max(a.m_Limbs.size(), b.m_Limbs.size());
+	for (size_t i = 0; i < n; i++)
+	{
+		uint32_t la = i < a.m_Limbs.size() ? a.m_Limbs[i] : 0;
+		uint32_t lb = i < b.m_Limbs.size() ? b.m_Limbs[i] : 0;
+		if (la != lb)
+			return la < lb ? -1 : 1;
+	}
+	return 0;
+}
+
+BigFloat BigFloat::AddMagnitudes(const BigFloat& a, const BigFloat& b, bool negative)
+{
+	size_t n = std::max(a.m_Limbs.size(), b.m_Limbs.size());
+
+	BigFloat r(0.0, (int)n);
+	r.m_Negative = negative;
+
+	uint64_t carry = 0;
+	for (size_t i = n; i-- > 0;)
+	{
+		uint64_t la = i < a.m_Limbs.size() ? a.m_Limbs[i] : 0;
+		uint64_t lb = i < b.m_Limbs.size() ? b.m_Limbs[i] : 0;
+		uint64_t sum = la + lb + carry;
+		r.m_Limbs[i] = (uint32_t)sum;
+		carry = sum >> 32;
+	}
+	return r;
+}
+
+// Assumes |a| >= |b|
+BigFloat BigFloat::SubMagnitudes(const BigFloat& a, const BigFloat& b, bool negative)
+{
+	size_t n = std::max(a.m_Limbs.size(), b.m_Limbs.size());
+
+	BigFloat r(0.0, (int)n);
+	r.m_Negative = negative;
+
+	int64_t borrow = 0;
+	for (size_t i = n; i-- > 0;)
+	{
+		int64_t la = i < a.m_Limbs.size() ? a.m_Limbs[i] : 0;
+		int64_t lb = i < b.m_Limbs.size() ? b.m_Limbs[i] : 0;
+		int64_t diff = la - lb - borrow;
+		borrow = diff < 0 ? 1 : 0;
+		r.m_Limbs[i] = (uint32_t)(diff + (borrow << 32));
+	}
+	return r;
+}
+
+BigFloat BigFloat::operator+(const BigFloat& other) const
+{
+	if (m_Negative == other.m_Negative)
+		return AddMagnitudes(*this, other, m_Negative);
+
+	if (CompareMagnitude(*this, other) >= 0)
+		return SubMagnitudes(*this, other, m_Negative);
+	else
+		return SubMagnitudes(other, *this, other.m_Negative);
+}
+
+BigFloat BigFloat::operator-(const BigFloat& other) const
+{
+	return *this + (-other);
+}
+
+BigFloat BigFloat::operator*(const BigFloat& other) const
+{
+	const auto& a = m_Limbs;
+	const auto& b = other.m_Limbs;
+	const size_t na = a.size(), nb = b.size();
+
+	// Schoolbook product of the limbs seen as big endian integers. The limb at
+	// index 1 of the full product is the integer part of the result.
+	std::vector<uint32_t> product(na + nb, 0);
+	for (size_t i = na; i-- > 0;)
+	{
+		if (a[i] == 0)
+			continue;
+
+		uint64_t carry = 0;
+		for (size_t j = nb; j-- > 0;)
+		{
+			uint64_t t = (uint64_t)a[i] * b[j] + product[i + j + 1] + carry;
+			product[i + j + 1] = (uint32_t)t;
+			carry = t >> 32;
+		}
+		product[i] += (uint32_t)carry;
+	}
+
+	BigFloat r(0.0, (int)std::max(na, nb));
+	r.m_Negative = m_Negative != other.m_Negative;
+	for (size_t i = 0; i < r.m_Limbs.size(); i++)
+		r.m_Limbs[i] = product[i + 1];
+
+	return r;
+}
+
+bool BigFloat::operator==(const BigFloat& other) const
+{
+	if (CompareMagnitude(*this, other) != 0)
+		return false;
+
+	return m_Negative == other.m_Negative || IsZero();
+}
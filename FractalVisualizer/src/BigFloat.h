@@ -0,0 +1,76 @@
+#pragma once
+
+#include <GLCore.h>
+
+#include <optional>
+#include <string_view>
+
+// Signed fixed point number with an arbitrary number of 32 bit limbs.
+// The first limb is the integer part and the rest are the fractional part,
+// so values must stay below 2^32 in magnitude (plenty for fractal orbits).
+class BigFloat
+{
+public:
+	static constexpr int MinLimbs = 3;
+
+	BigFloat(double value = 0.0, int limbs = MinLimbs);
+
+	// Number of limbs needed to resolve `pixelSize` with some guard bits left
+	static int LimbsForPixelSize(double pixelSize);
+
+	// Reads a decimal number like "-0.75", "1.5e-40" or "3", with enough limbs
+	// for all of its digits. Empty if the text is not a number or too big.
+	static std::optional<BigFloat> Parse(std::string_view text);
+
+	void SetPrecision(int limbs);
+	int GetPrecision() const { return (int)m_Limbs.size(); }
+
+	double ToDouble() const;
+	explicit operator double() const { return ToDouble(); }
+
+	bool IsZero() const;
+
+	BigFloat operator-() const;
+	BigFloat operator+(const BigFloat& other) const;
+	BigFloat operator-(const BigFloat& other) const;
+	BigFloat operator*(const BigFloat& other) const;
+
+	BigFloat& operator+=(const BigFloat& other) { return *this = *this + other; }
+	BigFloat& operator-=(const BigFloat& other) { return *this = *this - other; }
+
+	bool operator==(const BigFloat& other) const;
+	bool operator!=(const BigFloat& other) const { return !(*this == other); }
+
+private:
+	// Compares the magnitudes, returns -1, 0 or 1
+	static int CompareMagnitude(const BigFloat& a, const BigFloat& b);
+
+	static BigFloat AddMagnitudes(const BigFloat& a, const BigFloat& b, bool negative);
+	static BigFloat SubMagnitudes(const BigFloat& a, const BigFloat& b, bool negative);
+
+	bool m_Negative = false;
+	std::vector<uint32_t> m_Limbs;
+};
+
+struct BigComplex
+{
+	BigFloat x, y;
+
+	BigComplex() = default;
+	BigComplex(const glm::dvec2& v, int limbs = BigFloat::MinLimbs) : x(v.x, limbs), y(v.y, limbs) {}
+	BigComplex(const BigFloat& x, const BigFloat& y) : x(x), y(y) {}
+
+	void SetPrecision(int limbs) { x.SetPrecision(limbs); y.SetPrecision(limbs); }
+
+	glm::dvec2 ToDouble() const { return { x.ToDouble(), y.ToDouble() }; }
+
+	BigComplex operator+(const BigComplex& o) const { return { x + o.x, y + o.y }; }
+	BigComplex operator-(const BigComplex& o) const { return { x - o.x, y - o.y }; }
+	BigComplex operator*(const BigComplex& o) const { return { x * o.x - y * o.y, x * o.y + y * o.x }; }
+
+	// Three multiplications instead of four
+	BigComplex Square() const { BigFloat xy = x * y; return { x * x - y * y, xy + xy }; }
+
+	bool operator==(const BigComplex& o) const { return x == o.x && y == o.y; }
+	bool operator!=(const BigComplex& o) const { return !(*this == o); }
+};
@@ -0,0 +1,79 @@
+#include "CoarseFill.h"
+#include "ProgramCache.h"
+
+
+static const char* s_FillSrc = R"(#version 400 core
+layout (location = 0) out vec4 o_Samples;
+
+uniform sampler2D i_Samples;
+uniform int i_Stride;
+
+void main()
+{
+    ivec2 p = ivec2(gl_FragCoord.xy);
+    o_Samples = texelFetch(i_Samples, p / i_Stride * i_Stride, 0);
+}
+)";
+
+CoarseFill::CoarseFill(GLuint quadVA)
+	: m_QuadVA(quadVA)
+{
+	m_Program = CreateCachedShader(s_FillSrc);
+	glUseProgram(m_Program);
+
+	glUniform1i(glGetUniformLocation(m_Program, "i_Samples"), 0);
+	m_StrideLocation = glGetUniformLocation(m_Program, "i_Stride");
+}
+
+CoarseFill::~CoarseFill()
+{
+	glDeleteProgram(m_Program);
+	glDeleteFramebuffers(1, &m_FBO);
+	glDeleteTextures(1, &m_Texture);
+}
+
+void CoarseFill::Resize(const glm::uvec2& size)
+{
+	if (m_Size == size)
+		return;
+
+	m_Size = size;
+
+	glDeleteFramebuffers(1, &m_FBO);
+	glDeleteTextures(1, &m_Texture);
+
+	glGenTextures(1, &m_Texture);
+	glBindTexture(GL_TEXTURE_2D, m_Texture);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA32F, size.x, size.y);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	glGenFramebuffers(1, &m_FBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_Texture, 0);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		LOG_ERROR("Failed to create coarse fill framebuffer ({0}, {1})", size.x, size.y);
+		exit(EXIT_FAILURE);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void CoarseFill::Draw(GLuint texture, uint32_t stride)
+{
+	glUseProgram(m_Program);
+	glUniform1i(m_StrideLocation, (int)stride);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, texture);
+
+	glViewport(0, 0, m_Size.x, m_Size.y);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+	glDisable(GL_BLEND);
+
+	glBindVertexArray(m_QuadVA);
+	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
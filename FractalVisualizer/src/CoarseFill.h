@@ -0,0 +1,31 @@
+#pragma once
+
+#include <GLCore.h>
+
+// Samples the pixels added by a finer pass of the dynamic resolution start
+// from: every pixel takes the ones of the computed pixel at the corner of its
+// block, see ColorResolve.
+class CoarseFill
+{
+public:
+	// `quadVA` is the full screen quad the image is drawn with
+	CoarseFill(GLuint quadVA);
+	~CoarseFill();
+
+	void Resize(const glm::uvec2& size);
+
+	// Fills the blocks of the samples in `texture`
+	void Draw(GLuint texture, uint32_t stride);
+
+	GLuint GetTexture() const { return m_Texture; }
+
+private:
+	GLuint m_Program = 0;
+	GLint m_StrideLocation = -1;
+
+	GLuint m_QuadVA;
+	GLuint m_FBO = 0;
+	GLuint m_Texture = 0;
+
+	glm::uvec2 m_Size = { 0, 0 };
+};
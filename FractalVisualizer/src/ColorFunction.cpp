@@ -5,6 +5,11 @@ using namespace GLCore::Utils;
 
 static std::string uniform_s = "#uniform";
 
+static size_t AlignTo(size_t offset, size_t alignment)
+{
+	return (offset + alignment - 1) / alignment * alignment;
+}
+
 const std::shared_ptr<ColorFunction> ColorFunction::Default = std::make_shared<ColorFunction>(
 	"vec3 get_color(float i) { return vec3(1); }",
 	"default"
@@ -25,6 +30,11 @@ void ColorFunction::Initialize(std::string_view src)
 {
 	m_src = src;
 
+	// All the uniforms are gathered into a single block, placed where the first one was
+	size_t block_loc = std::string::npos;
+	std::string block_members;
+	size_t offset = 0;
+
 	for (size_t start; (start = m_src.find(uniform_s + ' ')) != std::string::npos;)
 	{
 		size_t end = m_src.substr(start).find_first_of(';') + start;
@@ -39,9 +49,11 @@ void ColorFunction::Initialize(std::string_view src)
 
 		//LOG_INFO("{1} - {0}", ss.str(), displayName);
 
+		size_t alignment = 4, size = 4;
+
 		if (type == "float")
 		{
-			uniform_glsl_text = "uniform float " + name;
+			uniform_glsl_text = "float " + name;
 
 			std::string min_s, max_s;
 			float val, speed;
@@ -55,7 +67,9 @@ void ColorFunction::Initialize(std::string_view src)
 		}
 		else if (type == "color")
 		{
-			uniform_glsl_text = "uniform vec3 " + name;
+			uniform_glsl_text = "vec3 " + name;
+			alignment = 16;
+			size = 12;
 
 			glm::vec3 def_color;
 			ss >> def_color.r >> def_color.g >> def_color.b;
@@ -64,7 +78,7 @@ void ColorFunction::Initialize(std::string_view src)
 		}
 		else if (type == "bool")
 		{
-			uniform_glsl_text = "uniform bool " + name;
+			uniform_glsl_text = "bool " + name;
 
 			bool def_val;
 			ss >> std::boolalpha >> def_val;
@@ -77,8 +91,15 @@ void ColorFunction::Initialize(std::string_view src)
 			throw custom_error(std::format("Uniform type `{0}` is not valid", type));
 		}
 
-		m_src.erase(start, end - start);
-		m_src.insert(start, uniform_glsl_text);
+		m_src.erase(start, end - start + 1);
+		if (block_loc == std::string::npos)
+			block_loc = start;
+
+		block_members += "\t" + uniform_glsl_text + ";\n";
+
+		offset = AlignTo(offset, alignment);
+		uniform->offset = offset;
+		offset += size;
 
 		if (ss.rdbuf()->in_avail() > 0)
 		{
@@ -90,10 +111,16 @@ void ColorFunction::Initialize(std::string_view src)
 
 		m_uniforms.push_back(uniform);
 	}
+
+	// Empty blocks are not valid glsl
+	if (block_loc != std::string::npos)
+		m_src.insert(block_loc, "layout (std140) uniform ColorParams\n{\n" + block_members + "};");
+
+	m_BlockSize = AlignTo(offset, 16);
 }
 
 ColorFunction::ColorFunction(const ColorFunction& other)
-	: m_name(other.m_name), m_src(other.m_src)
+	: m_name(other.m_name), m_src(other.m_src), m_BlockSize(other.m_BlockSize)
 {
 	m_uniforms.reserve(other.m_uniforms.size());
 	for (auto u : other.m_uniforms)
@@ -130,10 +157,50 @@ ColorFunction::~ColorFunction()
 {
 	for (auto u : m_uniforms)
 		delete u;
+
+	if (m_UBO[0] || m_UBO[1])
+		glDeleteBuffers(IM_ARRAYSIZE(m_UBO), m_UBO);
 }
 
-void ColorFunction::UpdateUniformsToShader(GLuint shader) const
+void ColorFunction::SetupShader(GLuint shader) const
 {
+	GLuint index = glGetUniformBlockIndex(shader, "ColorParams");
+	if (index != GL_INVALID_INDEX)
+		glUniformBlockBinding(shader, index, BlockBinding);
+}
+
+void ColorFunction::UpdateUniforms()
+{
+	UploadBlock(0, false);
+}
+
+void ColorFunction::UpdatePreviewUniforms()
+{
+	UploadBlock(1, true);
+}
+
+void ColorFunction::UploadBlock(int index, bool preview)
+{
+	if (m_BlockSize == 0)
+		return;
+
+	std::vector<uint8_t> block(m_BlockSize, 0);
 	for (auto uniform : m_uniforms)
-		uniform->UpdateToShader(shader);
+		uniform->WriteToBlock(block.data(), preview && !uniform->update);
+
+	if (!m_UBO[index])
+	{
+		glGenBuffers(1, &m_UBO[index]);
+		glBindBuffer(GL_UNIFORM_BUFFER, m_UBO[index]);
+		glBufferData(GL_UNIFORM_BUFFER, m_BlockSize, nullptr, GL_DYNAMIC_DRAW);
+	}
+
+	if (block != m_UploadedBlock[index])
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, m_UBO[index]);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, m_BlockSize, block.data());
+		m_UploadedBlock[index] = std::move(block);
+	}
+
+	glBindBufferBase(GL_UNIFORM_BUFFER, BlockBinding, m_UBO[index]);
 }
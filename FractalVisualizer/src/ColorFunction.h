@@ -21,10 +21,14 @@ struct Uniform
 	UniformType type;
 	bool update;
 
+	// Offset inside the std140 `ColorParams` block
+	size_t offset = 0;
+
 	Uniform(std::string_view name, std::string_view displayName, UniformType type, bool update)
 		: name(name), displayName(displayName), type(type), update(update) {}
 
-	virtual void UpdateToShader(GLuint shader) = 0;
+	// Writes the default value instead of the current one if `useDefault` is set
+	virtual void WriteToBlock(uint8_t* block, bool useDefault) const = 0;
 };
 
 struct FloatUniform : public Uniform
@@ -37,11 +41,9 @@ struct FloatUniform : public Uniform
 	FloatUniform(std::string_view name, std::string_view displayName, const glm::vec2& range, float default_val, float speed, bool update)
 		: Uniform(name, displayName, UniformType::FLOAT, update), range(range), default_val(default_val), val(default_val), speed(speed) {}
 
-	void UpdateToShader(GLuint shader) override
+	void WriteToBlock(uint8_t* block, bool useDefault) const override
 	{
-		glUseProgram(shader);
-		GLint location = glGetUniformLocation(shader, name.c_str());
-		glUniform1f(location, val);
+		std::memcpy(block + offset, useDefault ? &default_val : &val, sizeof(float));
 	}
 };
 
@@ -53,11 +55,9 @@ struct ColorUniform : public Uniform
 	ColorUniform(std::string_view name, std::string_view displayName, const glm::vec3& default_color, bool update)
 		: Uniform(name, displayName, UniformType::COLOR, update), color(default_color), default_color(default_color) {}
 
-	void UpdateToShader(GLuint shader) override
+	void WriteToBlock(uint8_t* block, bool useDefault) const override
 	{
-		glUseProgram(shader);
-		GLint location = glGetUniformLocation(shader, name.c_str());
-		glUniform3f(location, color.r, color.g, color.b);
+		std::memcpy(block + offset, glm::value_ptr(useDefault ? default_color : color), 3 * sizeof(float));
 	}
 };
 
@@ -69,11 +69,10 @@ struct BoolUniform : public Uniform
 	BoolUniform(std::string_view name, std::string_view displayName, bool default_val, bool update)
 		: Uniform(name, displayName, UniformType::BOOL, update), val(default_val), default_val(default_val) {}
 
-	void UpdateToShader(GLuint shader) override
+	void WriteToBlock(uint8_t* block, bool useDefault) const override
 	{
-		glUseProgram(shader);
-		GLint location = glGetUniformLocation(shader, name.c_str());
-		glUniform1i(location, val ? GL_TRUE : GL_FALSE);
+		uint32_t v = (useDefault ? default_val : val) ? GL_TRUE : GL_FALSE;
+		std::memcpy(block + offset, &v, sizeof(uint32_t));
 	}
 };
 
@@ -84,6 +83,15 @@ private:
 	std::string m_src;
 	std::string m_name;
 
+	// The `#uniform`s live in a std140 uniform buffer which is only
+	// uploaded when one of their values differs from the last upload.
+	// The second buffer holds the values seen by the preview.
+	size_t m_BlockSize = 0;
+	std::vector<uint8_t> m_UploadedBlock[2];
+	GLuint m_UBO[2] = {};
+
+	void UploadBlock(int index, bool preview);
+
 public:
 
 	ColorFunction(std::string_view src, std::string_view name);
@@ -94,9 +102,20 @@ public:
 
 	static const std::shared_ptr<ColorFunction> Default;
 
+	// Uniform buffer binding point of the `ColorParams` block
+	static constexpr GLuint BlockBinding = 1;
+
 	void Initialize(std::string_view src);
 
-	void UpdateUniformsToShader(GLuint shader) const;
+	// Connects the `ColorParams` block of a freshly linked shader to `BlockBinding`
+	void SetupShader(GLuint shader) const;
+
+	// Uploads the uniforms if they changed and binds them to `BlockBinding`
+	void UpdateUniforms();
+
+	// Same as `UpdateUniforms` but the uniforms which should not update the
+	// preview image keep their default value
+	void UpdatePreviewUniforms();
 
 	const std::vector<Uniform*>& GetUniforms() const { return m_uniforms; }
 
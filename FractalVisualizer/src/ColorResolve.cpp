@@ -0,0 +1,155 @@
+#include "ColorResolve.h"
+#include "ProgramCache.h"
+#include "IndexHistogram.h"
+
+
+static const char* s_ResolveSrc = R"(#version 400 core
+layout (location = 0) out vec4 o_Color;
+
+// (mean, variance, coverage, 0) of the color index, see add_sample in the fractal shaders
+uniform sampler2D i_Samples;
+uniform int i_Stride;
+uniform vec3 i_SetColor;
+
+#color
+
+// Index the histogram is spread over when equalizing, how many times the
+// colors repeat over it is up to the scale of the color function
+const float equalized_range = 100.0;
+
+float color_index(float index)
+{
+#ifdef EQUALIZE
+    return equalize(index) * equalized_range;
+#else
+    return index;
+#endif
+}
+
+// Normal quantiles of 8 equally likely indices, scaled to unit variance
+const float resolve_quantiles[4] = float[](0.1705, 0.5298, 0.9617, 1.663);
+
+void main()
+{
+    ivec2 p = ivec2(gl_FragCoord.xy) / i_Stride * i_Stride;
+    vec4 samples = texelFetch(i_Samples, p, 0);
+
+    // Only the mean and variance of the index are known, the colors are
+    // averaged over a normal distribution with them. That is an approximation
+    // for any spread: even two samples are colored at indices between theirs,
+    // never at their own, so pixels with samples far apart (on the border of
+    // the set, or with cyclic palettes) differ the most from blending.
+    float spread = sqrt(max(samples.y, 0.0));
+    vec3 color = vec3(0.0);
+    for (int k = 0; k < 4; k++)
+    {
+        color += clamp(get_color(color_index(samples.x - resolve_quantiles[k] * spread)), 0.0, 1.0);
+        color += clamp(get_color(color_index(samples.x + resolve_quantiles[k] * spread)), 0.0, 1.0);
+    }
+
+    o_Color = vec4(mix(i_SetColor, color / 8.0, samples.z), 1.0);
+}
+)";
+
+ColorResolve::ColorResolve(GLuint quadVA)
+	: m_QuadVA(quadVA)
+{
+}
+
+ColorResolve::~ColorResolve()
+{
+	glDeleteProgram(m_Program);
+	glDeleteFramebuffers(1, &m_FBO);
+	glDeleteTextures(1, &m_Texture);
+}
+
+void ColorResolve::SetColorFunction(const std::shared_ptr<ColorFunction>& colorFunc)
+{
+	m_ColorFunction = colorFunc;
+	Compile();
+}
+
+void ColorResolve::SetEqualize(bool equalize)
+{
+	if (m_Equalize == equalize)
+		return;
+
+	m_Equalize = equalize;
+	if (m_ColorFunction)
+		Compile();
+}
+
+void ColorResolve::Compile()
+{
+	std::string source = s_ResolveSrc;
+	size_t color_loc = source.find("#color");
+	source.erase(color_loc, 6);
+	source.insert(color_loc, m_ColorFunction->GetSource());
+
+	// The histogram is a shader storage buffer, which needs GLSL 4.30
+	if (m_Equalize)
+	{
+		source.replace(0, source.find('\n'), "#version 430 core");
+		source.insert(source.find('\n') + 1, "#define EQUALIZE\n" + IndexHistogram::GetSource());
+	}
+
+	if (m_Program)
+		glDeleteProgram(m_Program);
+
+	m_Program = CreateCachedShader(source);
+	glUseProgram(m_Program);
+
+	m_ColorFunction->SetupShader(m_Program);
+
+	glUniform1i(glGetUniformLocation(m_Program, "i_Samples"), 0);
+	m_StrideLocation = glGetUniformLocation(m_Program, "i_Stride");
+	m_SetColorLocation = glGetUniformLocation(m_Program, "i_SetColor");
+}
+
+void ColorResolve::Resize(const glm::uvec2& size)
+{
+	if (m_Size == size)
+		return;
+
+	m_Size = size;
+
+	glDeleteFramebuffers(1, &m_FBO);
+	glDeleteTextures(1, &m_Texture);
+
+	glGenTextures(1, &m_Texture);
+	glBindTexture(GL_TEXTURE_2D, m_Texture);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, size.x, size.y);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	glGenFramebuffers(1, &m_FBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_Texture, 0);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		LOG_ERROR("Failed to create color resolve framebuffer ({0}, {1})", size.x, size.y);
+		exit(EXIT_FAILURE);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void ColorResolve::Draw(GLuint samples, uint32_t stride, const glm::vec3& setColor)
+{
+	glUseProgram(m_Program);
+	glUniform1i(m_StrideLocation, (int)stride);
+	glUniform3fv(m_SetColorLocation, 1, glm::value_ptr(setColor));
+	m_ColorFunction->UpdateUniforms();
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, samples);
+
+	glViewport(0, 0, m_Size.x, m_Size.y);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+	glDisable(GL_BLEND);
+
+	glBindVertexArray(m_QuadVA);
+	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
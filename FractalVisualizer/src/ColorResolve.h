@@ -0,0 +1,51 @@
+#pragma once
+
+#include <GLCore.h>
+
+#include "ColorFunction.h"
+
+// Turns the samples left by the fractal shaders into the image. Instead of
+// colors they keep, for every pixel, the weighted mean and variance of the
+// color index of the samples that escaped and how much of the pixel those
+// cover, the rest being the set color. Only this pass runs the color
+// function, so changing it or its uniforms recolors the render right away.
+// Pixels whose samples spread over several colors get the average over a
+// normal distribution of the index. The samples themselves are not kept, so
+// this only approximates blending their colors, whatever their number.
+class ColorResolve
+{
+public:
+	// `quadVA` is the full screen quad the image is drawn with
+	ColorResolve(GLuint quadVA);
+	~ColorResolve();
+
+	void SetColorFunction(const std::shared_ptr<ColorFunction>& colorFunc);
+
+	// Maps the index through the IndexHistogram bound at its binding before
+	// coloring, so the colors spread evenly over whatever is in view
+	void SetEqualize(bool equalize);
+
+	void Resize(const glm::uvec2& size);
+
+	// Colors `samples`. With a `stride` over 1 every block shows the pixel at
+	// its corner, see FractalVisualizer::SetDynamicResolution.
+	void Draw(GLuint samples, uint32_t stride, const glm::vec3& setColor);
+
+	GLuint GetTexture() const { return m_Texture; }
+
+private:
+	void Compile();
+
+	std::shared_ptr<ColorFunction> m_ColorFunction;
+	bool m_Equalize = false;
+
+	GLuint m_Program = 0;
+	GLint m_StrideLocation = -1;
+	GLint m_SetColorLocation = -1;
+
+	GLuint m_QuadVA;
+	GLuint m_FBO = 0;
+	GLuint m_Texture = 0;
+
+	glm::uvec2 m_Size = { 0, 0 };
+};
@@ -0,0 +1,59 @@
+#include "ComputeShader.h"
+#include "ProgramCache.h"
+
+static GLuint BuildComputeShader(const std::string& source)
+{
+	GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+	const char* src = source.c_str();
+	glShaderSource(shader, 1, &src, nullptr);
+	glCompileShader(shader);
+
+	GLint status;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+	if (status == GL_FALSE)
+	{
+		GLint length;
+		glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+		std::string log(length, '\0');
+		glGetShaderInfoLog(shader, length, &length, log.data());
+
+		LOG_ERROR("Failed to compile the compute shader:\n{0}", log);
+		exit(EXIT_FAILURE);
+	}
+
+	GLuint program = glCreateProgram();
+	glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	glAttachShader(program, shader);
+	glLinkProgram(program);
+	glDeleteShader(shader);
+
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+	if (status == GL_FALSE)
+	{
+		GLint length;
+		glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+		std::string log(length, '\0');
+		glGetProgramInfoLog(program, length, &length, log.data());
+
+		LOG_ERROR("Failed to link the compute shader:\n{0}", log);
+		exit(EXIT_FAILURE);
+	}
+
+	return program;
+}
+
+GLuint CreateComputeShader(const std::string& source)
+{
+	return GetCachedProgram("compute", source, BuildComputeShader);
+}
+
+glm::uvec2 DispatchSize(uint32_t groups)
+{
+	// Guaranteed minimum of GL_MAX_COMPUTE_WORK_GROUP_COUNT
+	constexpr uint32_t maxGroups = 65535;
+
+	if (groups <= maxGroups)
+		return { groups, 1 };
+
+	return { maxGroups, (groups + maxGroups - 1) / maxGroups };
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <GLCore.h>
+
+// Compiles and links a compute program, GLCore only builds vertex + fragment ones.
+// Goes through the program cache like CreateCachedShader.
+GLuint CreateComputeShader(const std::string& source);
+
+// Splits `groups` 1D work groups in two dimensions so a dispatch never exceeds the
+// per dimension limit. Kernels rebuild the linear index from gl_WorkGroupID.
+glm::uvec2 DispatchSize(uint32_t groups);
@@ -0,0 +1,112 @@
+#include "CpuKernelImpl.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// One pixel at a time, for processors without AVX2 or builds not targeting it
+struct LanesScalar
+{
+	static constexpr size_t Width = 1;
+
+	using D = double;
+	using I = uint64_t;
+	using M = bool;
+
+	static D Load(const double* p) { return *p; }
+	static I LoadI(const uint64_t* p) { return *p; }
+	static void Store(double* p, D v) { *p = v; }
+	static void StoreI(uint64_t* p, I v) { *p = v; }
+	static void StoreMask(uint8_t* p, M m) { *p = m; }
+
+	static D Set(double v) { return v; }
+	static I SetI(uint64_t v) { return v; }
+	static M None() { return false; }
+
+	static D Add(D a, D b) { return a + b; }
+	static D Sub(D a, D b) { return a - b; }
+	static D Mul(D a, D b) { return a * b; }
+	static I AddI(I a, I b) { return a + b; }
+
+	static M Less(D a, D b) { return a < b; }
+	static M LessEq(D a, D b) { return a <= b; }
+	static M IsPow2(I n) { return (n & (n - 1)) == 0; }
+
+	static M And(M a, M b) { return a && b; }
+	static M AndNot(M a, M b) { return a && !b; }
+	static M Or(M a, M b) { return a || b; }
+	static bool Any(M m) { return m; }
+
+	static D Select(M m, D a, D b) { return m ? a : b; }
+	static I SelectI(M m, I a, I b) { return m ? a : b; }
+};
+
+enum class Isa
+{
+	AVX2,
+	AVX512
+};
+
+static bool Supports(Isa isa)
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return false;
+
+	// The OS has to save the wide registers too
+	__cpuid(info, 1);
+	if (!(info[2] & (1 << 27)))
+		return false;
+	const unsigned long long xcr0 = _xgetbv(0);
+
+	__cpuidex(info, 7, 0);
+	switch (isa)
+	{
+	case Isa::AVX2:   return (info[1] & (1 << 5)) && (xcr0 & 0x06) == 0x06;
+	case Isa::AVX512: return (info[1] & (1 << 16)) && (info[1] & (1 << 17)) && (xcr0 & 0xE6) == 0xE6;
+	}
+	return false;
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	switch (isa)
+	{
+	case Isa::AVX2:   return __builtin_cpu_supports("avx2");
+	case Isa::AVX512: return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq");
+	}
+	return false;
+#else
+	return false;
+#endif
+}
+
+struct KernelChoice
+{
+	CpuKernelFn kernel;
+	const char* name;
+};
+
+static KernelChoice ChooseKernel()
+{
+	if (GetCpuKernelAVX512() && Supports(Isa::AVX512))
+		return { GetCpuKernelAVX512(), "AVX-512" };
+	if (GetCpuKernelAVX2() && Supports(Isa::AVX2))
+		return { GetCpuKernelAVX2(), "AVX2" };
+	return { &IterateOrbits<LanesScalar>, "Scalar" };
+}
+
+static const KernelChoice& GetChoice()
+{
+	static const KernelChoice choice = ChooseKernel();
+	return choice;
+}
+
+CpuKernelFn GetCpuKernel()
+{
+	return GetChoice().kernel;
+}
+
+const char* GetCpuKernelName()
+{
+	return GetChoice().name;
+}
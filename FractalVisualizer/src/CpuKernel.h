@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// Orbits of a batch of pixels as a structure of arrays. The arrays are padded
+// to a multiple of `CpuKernelPadding`, padding lanes should start escaped.
+struct CpuOrbits
+{
+	double* zx;
+	double* zy;
+	double* cx;
+	double* cy;
+	double* savedX; // z saved by the periodicity check
+	double* savedY;
+	uint64_t* iters;  // Total iterations of the current sample, updated
+	uint8_t* interior; // Output, set when a cycle was found
+	size_t count;
+};
+
+struct CpuKernelParams
+{
+	uint32_t itersPerFrame;
+	uint32_t eqExp;
+	double periodEps2; // Same as period_eps2 in the shaders
+};
+
+// Iterates z^eqExp + c like the loop of the regular double kernel of the
+// fractal shaders, for at most `itersPerFrame` iterations or until z escapes
+// or is caught in a cycle. Lanes that stop are masked out while the rest of
+// their group carries on.
+using CpuKernelFn = void (*)(const CpuKernelParams& params, CpuOrbits& orbits);
+
+static constexpr size_t CpuKernelPadding = 8;
+
+// Widest kernel the build and the running processor support
+CpuKernelFn GetCpuKernel();
+const char* GetCpuKernelName();
+
+// Defined in the translation units built for each instruction set, null if
+// the compiler was not targeting it
+CpuKernelFn GetCpuKernelAVX2();
+CpuKernelFn GetCpuKernelAVX512();
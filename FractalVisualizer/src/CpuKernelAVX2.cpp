@@ -0,0 +1,66 @@
+#include "CpuKernel.h"
+
+// Built with AVX2 enabled, see premake5.lua. Only called after checking the
+// processor supports it.
+#if defined(__AVX2__)
+#include "CpuKernelImpl.h"
+
+#include <immintrin.h>
+
+struct LanesAVX2
+{
+	static constexpr size_t Width = 4;
+
+	using D = __m256d;
+	using I = __m256i;
+	using M = __m256d; // All bits set in the active lanes
+
+	static D Load(const double* p) { return _mm256_loadu_pd(p); }
+	static I LoadI(const uint64_t* p) { return _mm256_loadu_si256((const __m256i*)p); }
+	static void Store(double* p, D v) { _mm256_storeu_pd(p, v); }
+	static void StoreI(uint64_t* p, I v) { _mm256_storeu_si256((__m256i*)p, v); }
+
+	static void StoreMask(uint8_t* p, M m)
+	{
+		const int bits = _mm256_movemask_pd(m);
+		for (size_t i = 0; i < Width; i++)
+			p[i] = (bits >> i) & 1;
+	}
+
+	static D Set(double v) { return _mm256_set1_pd(v); }
+	static I SetI(uint64_t v) { return _mm256_set1_epi64x((long long)v); }
+	static M None() { return _mm256_setzero_pd(); }
+
+	static D Add(D a, D b) { return _mm256_add_pd(a, b); }
+	static D Sub(D a, D b) { return _mm256_sub_pd(a, b); }
+	static D Mul(D a, D b) { return _mm256_mul_pd(a, b); }
+	static I AddI(I a, I b) { return _mm256_add_epi64(a, b); }
+
+	static M Less(D a, D b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+	static M LessEq(D a, D b) { return _mm256_cmp_pd(a, b, _CMP_LE_OQ); }
+
+	static M IsPow2(I n)
+	{
+		I masked = _mm256_and_si256(n, _mm256_sub_epi64(n, SetI(1)));
+		return _mm256_castsi256_pd(_mm256_cmpeq_epi64(masked, _mm256_setzero_si256()));
+	}
+
+	static M And(M a, M b) { return _mm256_and_pd(a, b); }
+	static M AndNot(M a, M b) { return _mm256_andnot_pd(b, a); }
+	static M Or(M a, M b) { return _mm256_or_pd(a, b); }
+	static bool Any(M m) { return _mm256_movemask_pd(m) != 0; }
+
+	static D Select(M m, D a, D b) { return _mm256_blendv_pd(b, a, m); }
+	static I SelectI(M m, I a, I b) { return _mm256_castpd_si256(_mm256_blendv_pd(_mm256_castsi256_pd(b), _mm256_castsi256_pd(a), m)); }
+};
+
+CpuKernelFn GetCpuKernelAVX2()
+{
+	return &IterateOrbits<LanesAVX2>;
+}
+#else
+CpuKernelFn GetCpuKernelAVX2()
+{
+	return nullptr;
+}
+#endif
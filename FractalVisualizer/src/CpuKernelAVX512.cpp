@@ -0,0 +1,65 @@
+#include "CpuKernel.h"
+
+// Built with AVX-512 enabled, see premake5.lua. Only called after checking the
+// processor supports it.
+#if defined(__AVX512F__) && defined(__AVX512DQ__)
+#include "CpuKernelImpl.h"
+
+#include <immintrin.h>
+
+struct LanesAVX512
+{
+	static constexpr size_t Width = 8;
+
+	using D = __m512d;
+	using I = __m512i;
+	using M = __mmask8;
+
+	static D Load(const double* p) { return _mm512_loadu_pd(p); }
+	static I LoadI(const uint64_t* p) { return _mm512_loadu_si512(p); }
+	static void Store(double* p, D v) { _mm512_storeu_pd(p, v); }
+	static void StoreI(uint64_t* p, I v) { _mm512_storeu_si512(p, v); }
+
+	static void StoreMask(uint8_t* p, M m)
+	{
+		for (size_t i = 0; i < Width; i++)
+			p[i] = (m >> i) & 1;
+	}
+
+	static D Set(double v) { return _mm512_set1_pd(v); }
+	static I SetI(uint64_t v) { return _mm512_set1_epi64((long long)v); }
+	static M None() { return 0; }
+
+	static D Add(D a, D b) { return _mm512_add_pd(a, b); }
+	static D Sub(D a, D b) { return _mm512_sub_pd(a, b); }
+	static D Mul(D a, D b) { return _mm512_mul_pd(a, b); }
+	static I AddI(I a, I b) { return _mm512_add_epi64(a, b); }
+
+	static M Less(D a, D b) { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+	static M LessEq(D a, D b) { return _mm512_cmp_pd_mask(a, b, _CMP_LE_OQ); }
+
+	static M IsPow2(I n)
+	{
+		I masked = _mm512_and_si512(n, _mm512_sub_epi64(n, SetI(1)));
+		return _mm512_cmpeq_epi64_mask(masked, _mm512_setzero_si512());
+	}
+
+	static M And(M a, M b) { return a & b; }
+	static M AndNot(M a, M b) { return a & ~b; }
+	static M Or(M a, M b) { return a | b; }
+	static bool Any(M m) { return m != 0; }
+
+	static D Select(M m, D a, D b) { return _mm512_mask_blend_pd(m, b, a); }
+	static I SelectI(M m, I a, I b) { return _mm512_mask_blend_epi64(m, b, a); }
+};
+
+CpuKernelFn GetCpuKernelAVX512()
+{
+	return &IterateOrbits<LanesAVX512>;
+}
+#else
+CpuKernelFn GetCpuKernelAVX512()
+{
+	return nullptr;
+}
+#endif
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "CpuKernel.h"
+
+// Same as `sqr` in the shaders, the outputs may alias the inputs
+template<typename L>
+static inline void Sqr(typename L::D x, typename L::D y, typename L::D& rx, typename L::D& ry)
+{
+	rx = L::Mul(L::Add(x, y), L::Sub(x, y));
+	ry = L::Mul(L::Add(x, x), y);
+}
+
+// Kernel body shared by every instruction set. `L` provides the lane group:
+// `D` (doubles), `I` (64 bit integers) and `M` (masks), with `Width` lanes.
+template<typename L, bool Square>
+static void IterateOrbits(const CpuKernelParams& params, CpuOrbits& orbits)
+{
+	using D = typename L::D;
+	using I = typename L::I;
+	using M = typename L::M;
+
+	const D limit = L::Set(100.0);
+	const D eps2 = L::Set(params.periodEps2);
+	const I one = L::SetI(1);
+
+	for (size_t base = 0; base < orbits.count; base += L::Width)
+	{
+		D zx = L::Load(orbits.zx + base);
+		D zy = L::Load(orbits.zy + base);
+		const D cx = L::Load(orbits.cx + base);
+		const D cy = L::Load(orbits.cy + base);
+		D sx = L::Load(orbits.savedX + base);
+		D sy = L::Load(orbits.savedY + base);
+		I n = L::LoadI(orbits.iters + base);
+		M interior = L::None();
+
+		for (uint32_t i = 0; i < params.itersPerFrame; i++)
+		{
+			M active = L::AndNot(L::LessEq(L::Add(L::Mul(zx, zx), L::Mul(zy, zy)), limit), interior);
+			if (!L::Any(active))
+				break;
+
+			// Same operation order as `cpow` in the shaders
+			D rx = zx, ry = zy;
+			if constexpr (Square)
+				Sqr<L>(zx, zy, rx, ry);
+			else
+			{
+				D bx = zx, by = zy;
+				bool first = true;
+				for (uint32_t e = params.eqExp; e > 0; e >>= 1)
+				{
+					if (e & 1)
+					{
+						if (first)
+							rx = bx, ry = by;
+						else
+						{
+							D t = L::Sub(L::Mul(rx, bx), L::Mul(ry, by));
+							ry = L::Add(L::Mul(rx, by), L::Mul(ry, bx));
+							rx = t;
+						}
+						first = false;
+					}
+					if (e > 1)
+						Sqr<L>(bx, by, bx, by);
+				}
+			}
+
+			zx = L::Select(active, L::Add(rx, cx), zx);
+			zy = L::Select(active, L::Add(ry, cy), zy);
+			n = L::SelectI(active, L::AddI(n, one), n);
+
+			// Brent's cycle detection, see is_periodic
+			M save = L::And(active, L::IsPow2(n));
+			D dx = L::Sub(zx, sx);
+			D dy = L::Sub(zy, sy);
+			M periodic = L::AndNot(L::And(active, L::Less(L::Add(L::Mul(dx, dx), L::Mul(dy, dy)), eps2)), save);
+
+			sx = L::Select(save, zx, sx);
+			sy = L::Select(save, zy, sy);
+			interior = L::Or(interior, periodic);
+		}
+
+		L::Store(orbits.zx + base, zx);
+		L::Store(orbits.zy + base, zy);
+		L::Store(orbits.savedX + base, sx);
+		L::Store(orbits.savedY + base, sy);
+		L::StoreI(orbits.iters + base, n);
+		L::StoreMask(orbits.interior + base, interior);
+	}
+}
+
+template<typename L>
+static void IterateOrbits(const CpuKernelParams& params, CpuOrbits& orbits)
+{
+	if (params.eqExp == 2)
+		IterateOrbits<L, true>(params, orbits);
+	else
+		IterateOrbits<L, false>(params, orbits);
+}
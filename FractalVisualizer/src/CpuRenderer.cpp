@@ -0,0 +1,520 @@
+#include "CpuRenderer.h"
+#include "FractalVisualizer.h"
+
+#include <chrono>
+
+// Pixels gathered per kernel call, small enough for the batch to stay in cache
+static constexpr size_t BatchSize = 4096;
+
+// Side of the tiles, one batch of pixels each
+static constexpr uint32_t TileSize = 64;
+
+// Same as PIXEL_INTERIOR, PIXEL_START and PIXEL_COARSE in the shaders
+static constexpr uint8_t PixelInterior = 1;
+static constexpr uint8_t PixelStart = 8;
+static constexpr uint8_t PixelCoarse = 16;
+
+static float Rand(float s)
+{
+	float x = std::sin(s * 12.9898f) * 43758.5453f;
+	return x - std::floor(x);
+}
+
+void CpuRenderer::Batch::Resize(size_t count)
+{
+	const size_t padded = (count + CpuKernelPadding - 1) / CpuKernelPadding * CpuKernelPadding;
+	if (zx.size() >= padded)
+		return;
+
+	for (auto v : { &zx, &zy, &cx, &cy, &savedX, &savedY })
+		v->resize(padded);
+	iters.resize(padded);
+	interior.resize(padded);
+	pixels.resize(padded);
+}
+
+CpuOrbits CpuRenderer::Batch::GetOrbits(size_t count)
+{
+	// Padding lanes start escaped so they never iterate
+	const size_t padded = (count + CpuKernelPadding - 1) / CpuKernelPadding * CpuKernelPadding;
+	for (size_t i = count; i < padded; i++)
+	{
+		zx[i] = zy[i] = 1000.0;
+		cx[i] = cy[i] = savedX[i] = savedY[i] = 0.0;
+		iters[i] = 0;
+	}
+
+	return { zx.data(), zy.data(), cx.data(), cy.data(), savedX.data(), savedY.data(), iters.data(), interior.data(), padded };
+}
+
+CpuRenderer::CpuRenderer()
+	: m_Kernel(GetCpuKernel())
+{
+	m_Batches.resize(m_Scheduler.GetThreadCount());
+	SetParams(m_Params);
+}
+
+CpuRenderer::~CpuRenderer()
+{
+	m_Scheduler.Cancel();
+}
+
+void CpuRenderer::SetParams(const Params& params)
+{
+	// How far the steps go does not change the result, so the iterations are
+	// just picked up by the next step
+	m_NextIterations = params.iterationsPerFrame;
+
+	Params same = params;
+	same.iterationsPerFrame = m_Params.iterationsPerFrame;
+	if (same == m_Params && m_PixelSize != 0.0)
+		return;
+
+	ResetRender();
+	m_Params = params;
+	UpdateRange();
+}
+
+void CpuRenderer::UpdateRange()
+{
+	auto [xRange, yRange] = GetRange(m_Params.size, m_Params.radius, m_Params.center);
+	m_xRange = xRange;
+	m_yRange = yRange;
+	m_PixelSize = 2.0 * m_Params.radius / m_Params.size.y;
+}
+
+void CpuRenderer::ResetRender()
+{
+	m_Scheduler.Cancel();
+	m_Stepping = false;
+	m_Finished.clear();
+	m_Frame = 0;
+}
+
+template<typename T>
+static void ShiftImage(std::vector<T>& image, const glm::ivec2& size, const glm::ivec2& shift, size_t stride)
+{
+	const std::vector<T> old = image;
+
+	const int x0 = std::max(0, -shift.x);
+	const int x1 = std::min(size.x, size.x - shift.x);
+	for (int y = std::max(0, -shift.y); y < std::min(size.y, size.y - shift.y); y++)
+	{
+		const size_t src = ((size_t)(y + shift.y) * size.x + x0 + shift.x) * stride;
+		const size_t dst = ((size_t)y * size.x + x0) * stride;
+		std::copy(old.begin() + src, old.begin() + src + (x1 - x0) * stride, image.begin() + dst);
+	}
+}
+
+void CpuRenderer::Shift(const glm::ivec2& shift, const glm::dvec2& center)
+{
+	Wait();
+
+	m_Params.center = center;
+	UpdateRange();
+
+	if (m_Frame == 0 || m_Size != m_Params.size)
+	{
+		ResetRender();
+		return;
+	}
+
+	const glm::ivec2 size = m_Size;
+	ShiftImage(m_Z, size, shift, 1);
+	ShiftImage(m_Saved, size, shift, 1);
+	ShiftImage(m_Epoch, size, shift, 1);
+	ShiftImage(m_Iters, size, shift, 1);
+	ShiftImage(m_Flags, size, shift, 1);
+	ShiftImage(m_Samples, size, shift, 1);
+
+	// The pixels that came into view restart on the next step
+	for (int y = 0; y < size.y; y++)
+	{
+		const bool outside = y + shift.y < 0 || y + shift.y >= size.y;
+		for (int x = 0; x < size.x; x++)
+		{
+			if (outside || x + shift.x < 0 || x + shift.x >= size.x)
+				m_Flags[(size_t)y * size.x + x] = PixelStart;
+		}
+	}
+
+	RebuildTiles();
+}
+
+void CpuRenderer::SetStride(uint32_t stride)
+{
+	if (stride == m_Stride)
+		return;
+
+	Wait();
+
+	const uint32_t last = m_Stride;
+	m_Stride = stride;
+
+	// Before the first step there is nothing to keep, and a coarser stride
+	// would leave computed pixels around
+	if (m_Frame == 0 || m_Size != m_Params.size || stride > last)
+	{
+		ResetRender();
+		return;
+	}
+
+	for (uint32_t y = 0; y < m_Size.y; y++)
+	{
+		for (uint32_t x = 0; x < m_Size.x; x++)
+		{
+			const size_t p = (size_t)y * m_Size.x + x;
+			if (m_Flags[p] != PixelCoarse || !IsOnGrid((uint32_t)p))
+				continue;
+
+			m_Samples[p] = m_Samples[(size_t)(y / last * last) * m_Size.x + x / last * last];
+		}
+	}
+
+	RebuildTiles();
+}
+
+void CpuRenderer::RebuildTiles()
+{
+	std::lock_guard lock(m_FinishedMutex);
+	for (uint32_t i = 0; i < (uint32_t)m_Tiles.size(); i++)
+	{
+		TileState& tile = m_Tiles[i];
+		tile.active.clear();
+		for (uint32_t y = tile.pos.y; y < tile.pos.y + tile.size.y; y++)
+		{
+			for (uint32_t x = tile.pos.x; x < tile.pos.x + tile.size.x; x++)
+			{
+				if (!IsDone(y * m_Size.x + x))
+					tile.active.push_back(y * m_Size.x + x);
+			}
+		}
+
+		// Any pixel may have changed, so the whole image has to be shown again
+		m_Finished.push_back(i);
+	}
+}
+
+bool CpuRenderer::IsDone(uint32_t pixel) const
+{
+	if (m_Flags[pixel] == PixelStart)
+		return false;
+
+	if (m_Flags[pixel] == PixelCoarse)
+		return !IsOnGrid(pixel);
+
+	// The julia shader stops one epoch later
+	const uint32_t maxEpochs = m_Params.maxEpochs > 0 && m_Params.julia ? m_Params.maxEpochs + 1 : m_Params.maxEpochs;
+	return (m_Flags[pixel] & PixelInterior) || (maxEpochs > 0 && m_Epoch[pixel] >= maxEpochs);
+}
+
+bool CpuRenderer::IsOnGrid(uint32_t pixel) const
+{
+	return (pixel % m_Size.x) % m_Stride == 0 && (pixel / m_Size.x) % m_Stride == 0;
+}
+
+void CpuRenderer::Resize()
+{
+	m_Size = m_Params.size;
+
+	const size_t count = (size_t)m_Size.x * m_Size.y;
+	m_Z.assign(count, { 0.0, 0.0 });
+	m_Saved.assign(count, { 0.0, 0.0 });
+	m_Epoch.assign(count, 0);
+	m_Iters.assign(count, 0);
+	m_Flags.assign(count, 0);
+	m_Samples.assign(count, glm::vec4(0.f));
+
+	m_Tiles.clear();
+	for (uint32_t y = 0; y < m_Size.y; y += TileSize)
+	{
+		for (uint32_t x = 0; x < m_Size.x; x += TileSize)
+		{
+			TileState tile;
+			tile.pos = { x, y };
+			tile.size = glm::min(glm::uvec2(TileSize), m_Size - tile.pos);
+			m_Tiles.push_back(std::move(tile));
+		}
+	}
+
+	m_Frame = 0;
+}
+
+void CpuRenderer::Update()
+{
+	StartUpdate();
+	Wait();
+}
+
+void CpuRenderer::StartUpdate()
+{
+	if (m_Stepping || m_Params.size.x == 0 || m_Params.size.y == 0)
+		return;
+
+	if (m_Params.size != m_Size)
+		Resize();
+
+	m_Params.iterationsPerFrame = m_NextIterations;
+
+	std::vector<uint32_t> order;
+	order.reserve(m_Tiles.size());
+	for (uint32_t i = 0; i < (uint32_t)m_Tiles.size(); i++)
+	{
+		if (m_Frame == 0 || !m_Tiles[i].active.empty())
+			order.push_back(i);
+	}
+
+	if (m_Frame == 0)
+	{
+		// Nothing is known about the cost yet, start from the center of the
+		// view, where the user is looking
+		const glm::vec2 center = glm::vec2(m_Size) / 2.f;
+		auto distance = [&](uint32_t i) {
+			const glm::vec2 d = glm::vec2(m_Tiles[i].pos) + glm::vec2(m_Tiles[i].size) / 2.f - center;
+			return d.x * d.x + d.y * d.y;
+		};
+		std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return distance(a) < distance(b); });
+	}
+	else
+	{
+		// The slowest tiles first, so no one is left running alone at the end
+		std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return m_Tiles[a].cost > m_Tiles[b].cost; });
+	}
+
+	m_Stepping = true;
+	m_Scheduler.Run(order, [this](uint32_t tile, uint32_t thread) { StepTile(tile, thread); });
+}
+
+bool CpuRenderer::Poll()
+{
+	if (m_Stepping && !m_Scheduler.IsBusy())
+	{
+		m_Stepping = false;
+		m_Frame++;
+	}
+	return !m_Stepping;
+}
+
+void CpuRenderer::Wait()
+{
+	m_Scheduler.Wait();
+	Poll();
+}
+
+std::vector<CpuRenderer::Tile> CpuRenderer::TakeFinishedTiles()
+{
+	std::vector<uint32_t> finished;
+	{
+		std::lock_guard lock(m_FinishedMutex);
+		finished.swap(m_Finished);
+	}
+
+	std::vector<Tile> tiles;
+	tiles.reserve(finished.size());
+	for (uint32_t i : finished)
+		tiles.push_back(m_Tiles[i]);
+	return tiles;
+}
+
+size_t CpuRenderer::GetActivePixels() const
+{
+	if (m_Frame == 0)
+		return (size_t)m_Params.size.x * m_Params.size.y;
+
+	size_t count = 0;
+	for (const auto& tile : m_Tiles)
+		count += tile.active.size();
+	return count;
+}
+
+void CpuRenderer::StepTile(uint32_t index, uint32_t thread)
+{
+	const auto start = std::chrono::steady_clock::now();
+	TileState& tile = m_Tiles[index];
+
+	if (m_Frame == 0)
+	{
+		tile.active.clear();
+		for (uint32_t y = tile.pos.y; y < tile.pos.y + tile.size.y; y++)
+		{
+			for (uint32_t x = tile.pos.x; x < tile.pos.x + tile.size.x; x++)
+			{
+				const uint32_t p = y * m_Size.x + x;
+				if (IsOnGrid(p))
+					tile.active.push_back(p);
+				else
+					m_Flags[p] = PixelCoarse;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < tile.active.size(); i += BatchSize)
+		StepPixels(tile.active.data() + i, std::min(BatchSize, tile.active.size() - i), m_Batches[thread]);
+
+	std::erase_if(tile.active, [&](uint32_t p) { return IsDone(p); });
+
+	tile.cost = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::lock_guard lock(m_FinishedMutex);
+	m_Finished.push_back(index);
+}
+
+void CpuRenderer::StepPixels(const uint32_t* pixels, size_t count, Batch& batch)
+{
+	const Params& params = m_Params;
+
+	batch.Resize(count);
+
+	// Gather the pixels that iterate this step
+	size_t n = 0;
+	for (size_t k = 0; k < count; k++)
+	{
+		const uint32_t p = pixels[k];
+
+		const bool start = m_Frame == 0 || m_Flags[p] == PixelStart || m_Flags[p] == PixelCoarse;
+		if (start)
+		{
+			// The pixels reached by the stride keep the samples of their block
+			if (m_Frame == 0 || m_Flags[p] != PixelCoarse)
+				m_Samples[p] = glm::vec4(0.f);
+
+			m_Z[p] = { 0.0, 0.0 };
+			m_Saved[p] = { 0.0, 0.0 };
+			m_Epoch[p] = 0;
+			m_Iters[p] = 0;
+			m_Flags[p] = 0;
+		}
+
+		const uint32_t epoch = m_Epoch[p];
+		if (params.maxEpochs > 0 && (params.julia ? epoch > (uint32_t)params.maxEpochs : epoch >= (uint32_t)params.maxEpochs))
+			continue;
+
+		glm::dvec2 c;
+		if (params.julia)
+		{
+			c = params.juliaC;
+			if (start)
+				m_Z[p] = MapPos(GetSamplePos(p, epoch));
+		}
+		else
+		{
+			c = MapPos(GetSamplePos(p, epoch));
+			if (m_Iters[p] == 0 && InMainComponents(c))
+			{
+				if (epoch == 0)
+					m_Samples[p] = glm::vec4(0.f);
+
+				m_Flags[p] = PixelInterior;
+				continue;
+			}
+		}
+
+		batch.zx[n] = m_Z[p].x;
+		batch.zy[n] = m_Z[p].y;
+		batch.cx[n] = c.x;
+		batch.cy[n] = c.y;
+		batch.savedX[n] = m_Saved[p].x;
+		batch.savedY[n] = m_Saved[p].y;
+		batch.iters[n] = m_Iters[p];
+		batch.pixels[n] = p;
+		n++;
+	}
+
+	CpuOrbits orbits = batch.GetOrbits(n);
+	const CpuKernelParams kernelParams = {
+		(uint32_t)params.iterationsPerFrame,
+		(uint32_t)params.eqExponent,
+		(1e-3 * m_PixelSize) * (1e-3 * m_PixelSize)
+	};
+	m_Kernel(kernelParams, orbits);
+
+	// Scatter the results back
+	for (size_t k = 0; k < n; k++)
+	{
+		const uint32_t p = batch.pixels[k];
+		const glm::dvec2 z = { batch.zx[k], batch.zy[k] };
+		const uint32_t iters = (uint32_t)batch.iters[k];
+
+		m_Saved[p] = { batch.savedX[k], batch.savedY[k] };
+
+		if (batch.interior[k] || iters - m_Iters[p] == (uint32_t)params.iterationsPerFrame)
+		{
+			m_Z[p] = z;
+			m_Iters[p] = iters;
+			m_Flags[p] = batch.interior[k] ? PixelInterior : 0;
+
+			// Pixels started from the samples of their block still have to show they are inside
+			if (batch.interior[k] && m_Epoch[p] == 0)
+				m_Samples[p] = glm::vec4(0.f);
+			continue;
+		}
+
+		const uint32_t epoch = m_Epoch[p];
+		AddSample(p, EscapeSample(z, epoch, (int)iters));
+
+		// The julia shader restarts from the position of the sample that escaped
+		m_Z[p] = params.julia ? MapPos(GetSamplePos(p, epoch)) : glm::dvec2(0.0, 0.0);
+		m_Epoch[p] = epoch + 1;
+		m_Iters[p] = 0;
+	}
+}
+
+glm::dvec2 CpuRenderer::GetSamplePos(uint32_t pixel, uint32_t epoch) const
+{
+	const glm::dvec2 fragCoord = { pixel % m_Size.x + 0.5, pixel / m_Size.x + 0.5 };
+	return fragCoord + glm::dvec2(Rand((float)epoch), Rand((float)(epoch + 1)));
+}
+
+glm::dvec2 CpuRenderer::MapPos(const glm::dvec2& pos) const
+{
+	// Same as `map` in the shaders
+	return {
+		m_xRange.x + ((m_xRange.y - m_xRange.x) / m_Size.x) * pos.x,
+		m_yRange.x + ((m_yRange.y - m_yRange.x) / m_Size.y) * pos.y
+	};
+}
+
+void CpuRenderer::AddSample(uint32_t pixel, const glm::vec2& sample)
+{
+	// Same as add_sample in the shaders
+	glm::vec4& samples = m_Samples[pixel];
+
+	const float coverage = samples.z + (1.f - samples.z) * sample.y;
+	const float weight = sample.y / coverage;
+
+	const float d = sample.x - samples.x;
+	samples = glm::vec4(samples.x + weight * d, (1.f - weight) * (samples.y + weight * d * d), coverage, 0.f);
+}
+
+glm::vec2 CpuRenderer::EscapeSample(const glm::dvec2& z, uint32_t epoch, int n) const
+{
+	const Params& params = m_Params;
+
+	if (params.fadeThreshold > 0 && n > params.fadeThreshold)
+		epoch += (uint32_t)((float)n / (float)params.fadeThreshold);
+
+	float index = (float)n;
+	if (params.smoothColor)
+	{
+		float log_zn = std::log((float)(z.x * z.x + z.y * z.y)) / 2.f;
+		float nu = std::log(log_zn / std::log(2.f)) / std::log((float)params.eqExponent);
+
+		index = n + 1 - nu + 1.3f;
+	}
+
+	return glm::vec2(index, 1.f / (float)(epoch + 1));
+}
+
+bool CpuRenderer::InMainComponents(const glm::dvec2& c) const
+{
+	// Same as in_main_components in mandelbrot.glsl
+	if (m_Params.eqExponent != 2 || m_PixelSize < 1e-14)
+		return false;
+
+	double x = c.x - 0.25;
+	double q = x * x + c.y * c.y;
+	if (q * (q + x) <= 0.25 * c.y * c.y)
+		return true;
+
+	return (c.x + 1.0) * (c.x + 1.0) + c.y * c.y <= 0.0625;
+}
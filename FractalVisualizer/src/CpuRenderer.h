@@ -0,0 +1,158 @@
+#pragma once
+
+#include <GLCore.h>
+
+#include "CpuKernel.h"
+#include "TileScheduler.h"
+
+// Renders the regular double precision kernel of mandelbrot.glsl and
+// julia.glsl on the CPU, step by step with the same jitter, epochs and smooth
+// coloring. No GL context is needed, the result are the same samples the
+// shaders leave, laid out like their texture and colored by ColorResolve.
+//
+// The image is split in square tiles, each with its own list of pixels with
+// work left. A step runs the tiles on every core through a TileScheduler and
+// the finished ones can be shown while the rest are still running.
+class CpuRenderer
+{
+public:
+	struct Params
+	{
+		glm::dvec2 center = { 0.0, 0.0 };
+		double radius = 1.0;
+		glm::uvec2 size = { 1, 1 };
+		bool julia = false;
+		glm::dvec2 juliaC = { 0.0, 0.0 };
+		int iterationsPerFrame = 100;
+		int maxEpochs = 0;
+		int fadeThreshold = 0;
+		int eqExponent = 2;
+		bool smoothColor = false;
+
+		bool operator==(const Params&) const = default;
+	};
+
+	struct Tile
+	{
+		glm::uvec2 pos;
+		glm::uvec2 size;
+	};
+
+	CpuRenderer();
+	~CpuRenderer();
+
+	// Starts from scratch if any of them but the iterations changed
+	void SetParams(const Params& params);
+	const Params& GetParams() const { return m_Params; }
+
+	// Also cancels the step in progress
+	void ResetRender();
+
+	// Moves the view `shift` pixels (y up) to `center` keeping the state of
+	// the pixels still in view, the rest start from scratch
+	void Shift(const glm::ivec2& shift, const glm::dvec2& center);
+
+	// Only computes one pixel out of each block of `stride`, the rest are left
+	// for later, see FractalVisualizer::SetDynamicResolution. Lowering it keeps
+	// the state of the pixels computed so far and starts the new ones from the
+	// samples of their block.
+	void SetStride(uint32_t stride);
+
+	// Runs one step of every pixel with work left
+	void Update();
+
+	// Starts a step in the background, if none is running
+	void StartUpdate();
+
+	// True if no step is running anymore
+	bool Poll();
+	void Wait();
+
+	// The tiles of the current step finished since the last call. Their
+	// pixels are not touched again until the next step starts.
+	std::vector<Tile> TakeFinishedTiles();
+
+	// (mean, variance, coverage, 0) of the color index, see add_sample in the
+	// shaders. The first row is the bottom one, same as the texture.
+	const std::vector<glm::vec4>& GetSamples() const { return m_Samples; }
+	const glm::uvec2& GetSize() const { return m_Size; }
+
+	// Pixels the next step will iterate
+	size_t GetActivePixels() const;
+
+	int GetFrame() const { return m_Frame; }
+
+private:
+	// Scratch of a batch of pixels, see CpuOrbits
+	struct Batch
+	{
+		std::vector<double> zx, zy, cx, cy, savedX, savedY;
+		std::vector<uint64_t> iters;
+		std::vector<uint8_t> interior;
+		std::vector<uint32_t> pixels;
+
+		void Resize(size_t count);
+		CpuOrbits GetOrbits(size_t count);
+	};
+
+	struct TileState : Tile
+	{
+		// Pixels with work left
+		std::vector<uint32_t> active;
+
+		// Time of the last step, to start with the expensive ones
+		double cost = 0.0;
+	};
+
+	void Resize();
+	void UpdateRange();
+
+	// No more steps for the pixel
+	bool IsDone(uint32_t pixel) const;
+	bool IsOnGrid(uint32_t pixel) const;
+
+	// Lists the pixels with work left again and shows every tile again
+	void RebuildTiles();
+
+	// Steps the pixels of a tile, called from the workers
+	void StepTile(uint32_t tile, uint32_t thread);
+
+	// Steps `count` pixels, only touching their own state
+	void StepPixels(const uint32_t* pixels, size_t count, Batch& batch);
+
+	glm::dvec2 GetSamplePos(uint32_t pixel, uint32_t epoch) const;
+	glm::dvec2 MapPos(const glm::dvec2& pos) const;
+	void AddSample(uint32_t pixel, const glm::vec2& sample);
+	glm::vec2 EscapeSample(const glm::dvec2& z, uint32_t epoch, int n) const;
+	bool InMainComponents(const glm::dvec2& c) const;
+
+	Params m_Params;
+	int m_NextIterations = 100; // Iterations of the next step
+	glm::uvec2 m_Size = { 0, 0 };
+	int m_Frame = 0;
+	uint32_t m_Stride = 1;
+
+	CpuKernelFn m_Kernel;
+
+	// Same as FractalParams
+	glm::dvec2 m_xRange, m_yRange;
+	double m_PixelSize = 0.0;
+
+	// Per pixel state, the same as the state textures
+	std::vector<glm::dvec2> m_Z;
+	std::vector<glm::dvec2> m_Saved;
+	std::vector<uint32_t> m_Epoch;
+	std::vector<uint32_t> m_Iters;
+	std::vector<uint8_t> m_Flags;
+	std::vector<glm::vec4> m_Samples;
+
+	std::vector<TileState> m_Tiles;
+	std::vector<Batch> m_Batches; // One per worker
+	bool m_Stepping = false;
+
+	std::mutex m_FinishedMutex;
+	std::vector<uint32_t> m_Finished;
+
+	// Last, so the workers are stopped before anything they use is destroyed
+	TileScheduler m_Scheduler;
+};
@@ -1,7 +1,11 @@
 #include "FractalVisualizer.h"
+#include "ComputeShader.h"
+#include "ProgramCache.h"
 
 #include <fstream>
 #include <filesystem>
+#include <cstddef>
+#include <format>
 
 
 static double map(const double& x, const double& x0, const double& x1, const double& y0, const double& y1)
@@ -48,6 +52,10 @@ FractalVisualizer::FractalVisualizer(std::filesystem::path shaderSrcPath)
 {
 	SetShader(shaderSrcPath);
 
+	glGenBuffers(1, &m_ParamsUBO);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_ParamsUBO);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(ShaderParams), nullptr, GL_DYNAMIC_DRAW);
+
 	glGenVertexArrays(1, &m_QuadVA);
 	glBindVertexArray(m_QuadVA);
 
@@ -69,13 +77,17 @@ FractalVisualizer::FractalVisualizer(std::filesystem::path shaderSrcPath)
 	glGenBuffers(1, &m_QuadIB);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_QuadIB);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+	m_Resolve = std::make_unique<ColorResolve>(m_QuadVA);
 }
 
 FractalVisualizer::~FractalVisualizer()
 {
-	GLuint buffers[] = { m_QuadIB, m_QuadVB };
+	GLuint buffers[] = { m_QuadIB, m_QuadVB, m_ParamsUBO, m_ReferenceBuffer };
 	glDeleteBuffers(IM_ARRAYSIZE(buffers), buffers);
 
+	glDeleteTextures(1, &m_ReferenceTexture);
+
 	glDeleteVertexArrays(1, &m_QuadVA);
 
 	glDeleteProgram(m_Shader);
@@ -97,96 +109,212 @@ void FractalVisualizer::Update()
 		ResetRender();
 	}
 
-	// Shader uniforms
-	m_ColorFunction->UpdateUniformsToShader(m_Shader);
-
-	glUseProgram(m_Shader);
-	GLint location;
+	// While previewing only the first step of every view is worth it
+	if (m_Previewing && m_Frame >= PreviewSteps)
+		return;
 
-	location = glGetUniformLocation(m_Shader, "i_Size");
-	glUniform2ui(location, m_Size.x, m_Size.y);
+	if (m_Backend == Backend::Cpu)
+		UpdateCpu();
+	else
+		UpdateGpu();
 
-	location = glGetUniformLocation(m_Shader, "i_ItersPerFrame");
-	glUniform1ui(location, m_IterationsPerFrame);
+	m_ShouldResolve = true;
+	m_ShouldBuildHistogram = true;
 
-	location = glGetUniformLocation(m_Shader, "i_SetColor");
-	glUniform3f(location, m_SetColor.r, m_SetColor.g, m_SetColor.b);
+	if (m_Previewing || m_PreviewFade > 0)
+		UpdatePreview();
+}
 
-	location = glGetUniformLocation(m_Shader, "i_Frame");
-	glUniform1ui(location, m_Frame);
+void FractalVisualizer::UpdateGpu()
+{
+	UpdateResolution();
 
-	location = glGetUniformLocation(m_Shader, "i_MaxEpochs");
-	glUniform1ui(location, m_MaxEpochs);
+	if (m_Perturbation)
+		UpdateReference();
 
-	location = glGetUniformLocation(m_Shader, "i_SmoothColor");
-	glUniform1i(location, m_SmoothColor);
+	// Shader uniforms
+	UpdateParams();
 
-	location = glGetUniformLocation(m_Shader, "i_FadeThreshold");
-	glUniform1ui(location, m_FadeThreshold);
+	glUseProgram(m_Shader);
+	glUniform1ui(m_FrameLocation, m_Frame);
 
-	location = glGetUniformLocation(m_Shader, "i_EqExp");
-	glUniform1ui(location, m_EqExponent);
+	if (m_Perturbation)
+	{
+		glActiveTexture(GL_TEXTURE2);
+		glBindTexture(GL_TEXTURE_BUFFER, m_ReferenceTexture);
+	}
 
-	auto [xRange, yRange] = GetRange();
+	if (m_Backend == Backend::Compute)
+	{
+		// Every invocation only touches its own pixel, so the state is updated in place
+		const int state = m_StateIndex;
+		glBindImageTexture(0, m_Data[state], 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA32UI);
+		glBindImageTexture(1, m_Iter[state], 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA32UI);
+		glBindImageTexture(2, m_Samples[state], 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA32F);
+		if (m_DataLo[state])
+			glBindImageTexture(3, m_DataLo[state], 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA32UI);
+		if (m_Saved[state])
+			glBindImageTexture(4, m_Saved[state], 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA32UI);
+
+		// Refining while the tiles are still coarse
+		const bool guessing = IsGuessing() && m_GuessTile > 1;
+
+		// Only the pixels that had work left at the last rebuild are dispatched.
+		// The ones that finish in between just return early.
+		if (m_Frame == 0)
+		{
+			m_ActivePixels->Fill(m_WorkGroupSize);
+
+			if (IsGuessing())
+			{
+				if (!m_Guessing)
+					m_Guessing = std::make_unique<MarianiSilver>();
+				m_Guessing->Start(MarianiSilver::GridPixels(m_Size, GuessTileSize));
+
+				m_GuessTile = GuessTileSize;
+				m_GuessStats = {};
+			}
+		}
+		else if (m_ShouldRebuildActive || m_Frame % (guessing ? GuessInterval : CompactionInterval) == 0)
+		{
+			m_ShouldRebuildActive = false;
+
+			// The tiles are looked at once their borders had a chance to finish
+			if (guessing)
+			{
+				m_Guessing->Refine(m_Size, m_GuessTile);
+				m_GuessTile /= 2;
+
+				if (m_GuessTile == 1)
+				{
+					m_GuessStats = m_Guessing->ReadStats();
+					m_GuessDoneFrame = m_Frame;
+				}
+			}
+
+			// The julia shader stops one epoch later
+			uint32_t epochs = m_MaxEpochs > 0 && m_IsJulia ? m_MaxEpochs + 1 : m_MaxEpochs;
+			m_ActivePixels->Rebuild(epochs, m_WorkGroupSize);
+		}
+
+		glUseProgram(m_Shader);
+		m_ActivePixels->Dispatch();
+
+		// For the next step, and for whoever samples or reads back the texture
+		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+		m_Frame++;
+		return;
+	}
 
-	location = glGetUniformLocation(m_Shader, "i_xRange");
-	glUniform2d(location, xRange.x, xRange.y);
+	const int read = m_StateIndex;
+	const int write = 1 - m_StateIndex;
 
-	location = glGetUniformLocation(m_Shader, "i_yRange");
-	glUniform2d(location, yRange.x, yRange.y);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, m_Data[read]);
 
-	location = glGetUniformLocation(m_Shader, "i_Data");
-	glUniform1i(location, 0);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, m_Iter[read]);
 
-	location = glGetUniformLocation(m_Shader, "i_Iter");
-	glUniform1i(location, 1);
+	if (m_DataLo[read])
+	{
+		glActiveTexture(GL_TEXTURE3);
+		glBindTexture(GL_TEXTURE_2D, m_DataLo[read]);
+	}
 
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, m_InData);
+	if (m_Saved[read])
+	{
+		glActiveTexture(GL_TEXTURE4);
+		glBindTexture(GL_TEXTURE_2D, m_Saved[read]);
+	}
 
-	glActiveTexture(GL_TEXTURE1);
-	glBindTexture(GL_TEXTURE_2D, m_InIter);
+	glActiveTexture(GL_TEXTURE5);
+	glBindTexture(GL_TEXTURE_2D, m_Samples[read]);
 
 	// Draw
 	glViewport(0, 0, m_Size.x, m_Size.y);
-	glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
-
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-	if (m_Frame == 0)
-		glDisable(GL_BLEND);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_FBO[write]);
+	glDisable(GL_BLEND);
 
 	glBindVertexArray(m_QuadVA);
 	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
 
-	// Copy output buffers into input buffers
-	{
-		glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
-		glReadBuffer(GL_COLOR_ATTACHMENT1); // Out data
+	// The state just written is the input of the next step
+	m_StateIndex = write;
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, m_InData);
+	m_Frame++;
+}
 
-		glCopyTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32UI, 0, 0, m_Size.x, m_Size.y, 0);
+void FractalVisualizer::CopySettings(const FractalVisualizer& other)
+{
+	SetSetColor(other.GetSetColor());
+	SetMaxEpochs(other.GetMaxEpochs());
+	SetEqExponent(other.GetEqExponent());
+	SetSmoothColor(other.GetSmoothColor());
+	SetEqualize(other.GetEqualize());
+	SetFadeThreshold(other.GetFadeThreshold());
+	SetIterationsPerFrame(other.GetIterationsPerFrame());
+	SetPerturbation(other.GetPerturbation());
+	SetPrecision(other.GetPrecision());
+	SetBackend(other.GetBackend());
+	SetWorkGroupSize(other.GetWorkGroupSize());
+	SetRenderMode(other.GetRenderMode());
+}
 
+void FractalVisualizer::SetCenter(const glm::dvec2& center)
+{
+	m_Center = center;
+	m_DeepCenter = BigComplex(center, BigFloat::LimbsForPixelSize(GetPixelSize()));
+	ResetRender();
+}
 
-		glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
-		glReadBuffer(GL_COLOR_ATTACHMENT2); // Out iter
+void FractalVisualizer::SetDeepCenter(const BigComplex& center)
+{
+	m_DeepCenter = center;
+	m_Center = center.ToDouble();
+	ResetRender();
+}
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, m_InIter);
+void FractalVisualizer::MoveCenter(const glm::dvec2& offset)
+{
+	if (offset == glm::dvec2(0.0, 0.0))
+		return;
 
-		glCopyTexImage2D(GL_TEXTURE_2D, 0, GL_RG32UI, 0, 0, m_Size.x, m_Size.y, 0);
-	}
+	OffsetCenter(offset);
+	ResetRender();
+}
 
-	m_Frame++;
+void FractalVisualizer::OffsetCenter(const glm::dvec2& offset)
+{
+	// The offset is around the pixel size, so it must fit in the precision
+	int limbs = std::max(m_DeepCenter.x.GetPrecision(), BigFloat::LimbsForPixelSize(GetPixelSize()));
+	m_DeepCenter.SetPrecision(limbs);
+	m_DeepCenter = m_DeepCenter + BigComplex(offset, limbs);
+
+	m_Center = m_DeepCenter.ToDouble();
 }
 
-void FractalVisualizer::SetCenter(const glm::dvec2& center)
+void FractalVisualizer::Pan(const ImVec2& delta)
 {
-	m_Center = center;
-	ResetRender();
+	// The center moves against the drag, in texture pixels
+	m_PanRemainder += glm::dvec2(-delta.x, delta.y);
+	const glm::ivec2 shift = glm::ivec2(glm::round(m_PanRemainder));
+	m_PanRemainder -= glm::dvec2(shift);
+
+	if (shift == glm::ivec2(0, 0))
+		return;
+
+	OffsetCenter(glm::dvec2(shift) * GetPixelSize());
+
+	// Nothing worth keeping, or the guessing tiles would not line up anymore.
+	// While previewing, the preview already carries the image over.
+	const bool keep = m_Frame > 0 && !m_Previewing && m_ResolutionLevel == 0 && !m_ShouldCreateFramebuffer && !(IsGuessing() && m_GuessTile > 1)
+		&& std::abs(shift.x) < (int)m_Size.x && std::abs(shift.y) < (int)m_Size.y;
+
+	if (keep)
+		ShiftState(shift);
+	else
+		ResetRender();
 }
 
 void FractalVisualizer::SetRadius(double radius)
@@ -212,33 +340,79 @@ void FractalVisualizer::SetShader(std::filesystem::path shaderSrcPath)
 	std::ifstream file(shaderSrcPath);
 	m_ShaderSrc = std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
 
-	if (m_ColorFunction)
-		SetColorFunction(m_ColorFunction);
+	// Julia sets perturb z instead of c
+	m_IsJulia = m_ShaderSrc.find("#define JULIA") != std::string::npos;
+	m_ShouldUpdateReference = true;
+
+	CompileShader();
 
 	m_ShouldCreateFramebuffer = true;
 }
 
 void FractalVisualizer::SetColorFunction(const std::shared_ptr<ColorFunction>& colorFunc)
 {
+	// Only the resolve runs it, the samples stay valid
 	m_ColorFunction = colorFunc;
+	m_Resolve->SetColorFunction(m_ColorFunction);
+	m_ShouldResolve = true;
+}
+
+void FractalVisualizer::SetEqualize(bool equalize)
+{
+	m_Equalize = equalize;
+	m_Resolve->SetEqualize(equalize);
+	m_ShouldResolve = true;
+	m_ShouldBuildHistogram = true;
+}
 
+void FractalVisualizer::CompileShader()
+{
 	std::string source = m_ShaderSrc;
-	size_t color_loc = source.find("#color");
-	if (color_loc == std::string::npos)
+
+	// Right after the #version line
+	std::string defines;
+	if (m_Perturbation)
+		defines += "#define PERTURBATION\n";
+	else if (m_Precision == Precision::FloatFloat)
+		defines += "#define FLOAT_FLOAT\n";
+	else if (m_Precision == Precision::DoubleDouble)
+		defines += "#define DOUBLE_DOUBLE\n";
+
+	// The kernels only carry the features that are on
+	defines += std::format("#define EQ_EXP {}\n", m_EqExponent);
+	if (m_SmoothColor)
+		defines += "#define SMOOTH_COLOR\n";
+	if (m_FadeThreshold > 0)
+		defines += "#define FADE\n";
+	if (m_MaxEpochs > 0)
+		defines += "#define LIMIT_EPOCHS\n";
+
+	if (m_Backend == Backend::Compute)
 	{
-		LOG_ERROR("Shader does not have '#color'");
-		exit(EXIT_FAILURE);
+		defines += "#define COMPUTE_BACKEND\n";
+		defines += std::format("#define LOCAL_SIZE {}\n", m_WorkGroupSize);
+
+		// Compute shaders need GLSL 4.30
+		source.replace(0, source.find('\n'), "#version 430 core");
 	}
-	source.erase(color_loc, 6);
-	source.insert(color_loc, m_ColorFunction->GetSource());
+
+	source.insert(source.find('\n') + 1, defines);
 
 	if (m_Shader)
 		glDeleteProgram(m_Shader);
 
-	m_Shader = GLCore::Utils::CreateShader(source);
+	if (m_Backend == Backend::Compute)
+		m_Shader = CreateComputeShader(source);
+	else
+		m_Shader = CreateCachedShader(source);
 	glUseProgram(m_Shader);
 
-	m_ColorFunction->UpdateUniformsToShader(m_Shader);
+	// Everything that does not change every step is resolved once here
+	GLuint paramsIndex = glGetUniformBlockIndex(m_Shader, "FractalParams");
+	if (paramsIndex != GL_INVALID_INDEX)
+		glUniformBlockBinding(m_Shader, paramsIndex, ParamsBinding);
+
+	m_FrameLocation = glGetUniformLocation(m_Shader, "i_Frame");
 
 	int location = glGetUniformLocation(m_Shader, "i_Data");
 	glUniform1i(location, 0);
@@ -246,24 +420,42 @@ void FractalVisualizer::SetColorFunction(const std::shared_ptr<ColorFunction>& c
 	location = glGetUniformLocation(m_Shader, "i_Iter");
 	glUniform1i(location, 1);
 
-	ResetRender();
+	location = glGetUniformLocation(m_Shader, "i_RefOrbit");
+	glUniform1i(location, 2);
+
+	location = glGetUniformLocation(m_Shader, "i_DataLo");
+	glUniform1i(location, 3);
+
+	location = glGetUniformLocation(m_Shader, "i_Saved");
+	glUniform1i(location, 4);
+
+	// Image unit on the compute backend
+	location = glGetUniformLocation(m_Shader, "i_Samples");
+	glUniform1i(location, m_Backend == Backend::Compute ? 2 : 5);
+
+	if (m_Backend == Backend::Cpu && !m_CpuRenderer)
+		m_CpuRenderer = std::make_unique<CpuRenderer>();
 }
 
 void FractalVisualizer::SetIterationsPerFrame(int iterationsPerFrame)
 {
+	// The state carries over, only how far the next steps go changes
 	m_IterationsPerFrame = iterationsPerFrame;
-	ResetRender();
 }
 
 void FractalVisualizer::SetSetColor(const glm::vec3& setColor)
 {
 	m_SetColor = setColor;
-	ResetRender();
+	m_ShouldResolve = true;
 }
 
 void FractalVisualizer::SetFadeThreshold(int fadeThreshold)
 {
+	const bool toggled = (fadeThreshold > 0) != (m_FadeThreshold > 0);
 	m_FadeThreshold = fadeThreshold;
+
+	if (toggled)
+		CompileShader();
 	ResetRender();
 }
 
@@ -273,24 +465,440 @@ void FractalVisualizer::SetMaxEpochs(int maxEpochs)
 	if (maxEpochs != m_MaxEpochs && ((maxEpochs < m_MaxEpochs && maxEpochs != 0) || m_MaxEpochs == 0))
 		ResetRender();
 
+	// Removing the limit keeps the pixels going with the new kernel
+	const bool toggled = (maxEpochs > 0) != (m_MaxEpochs > 0);
 	m_MaxEpochs = maxEpochs;
+
+	if (toggled)
+		CompileShader();
 }
 
 void FractalVisualizer::SetSmoothColor(bool smoothColor)
 {
-	m_SmoothColor = smoothColor;
+	if (m_SmoothColor != smoothColor)
+	{
+		m_SmoothColor = smoothColor;
+		CompileShader();
+	}
 	ResetRender();
 }
 
 void FractalVisualizer::SetEqExponent(int eqExponent)
 {
-	m_EqExponent = eqExponent;
+	if (m_EqExponent != eqExponent)
+	{
+		m_EqExponent = eqExponent;
+		CompileShader();
+	}
+	m_ShouldUpdateReference = true;
 	ResetRender();
 }
 
+void FractalVisualizer::SetPerturbation(bool perturbation)
+{
+	if (m_Perturbation != perturbation)
+	{
+		m_Perturbation = perturbation;
+		m_ShouldUpdateReference = true;
+		m_ShouldCreateFramebuffer = true;
+
+		CompileShader();
+	}
+}
+
+void FractalVisualizer::SetPrecision(Precision precision)
+{
+	if (m_Precision != precision)
+	{
+		m_Precision = precision;
+		m_ShouldCreateFramebuffer = true;
+
+		CompileShader();
+	}
+}
+
+void FractalVisualizer::SetBackend(Backend backend)
+{
+	if (m_Backend != backend)
+	{
+		m_Backend = backend;
+		m_ShouldCreateFramebuffer = true;
+
+		CompileShader();
+	}
+}
+
+void FractalVisualizer::UpdateCpu()
+{
+	CpuRenderer::Params params;
+	params.center = m_Center;
+	params.radius = m_Radius;
+	params.size = m_Size;
+	params.julia = m_IsJulia;
+	params.juliaC = m_JuliaC;
+	params.iterationsPerFrame = m_IterationsPerFrame;
+	params.maxEpochs = m_MaxEpochs;
+	params.fadeThreshold = m_FadeThreshold;
+	params.eqExponent = m_EqExponent;
+	params.smoothColor = m_SmoothColor;
+
+	m_CpuRenderer->SetParams(params);
+	if (m_Frame == 0)
+		m_CpuRenderer->ResetRender();
+
+	const bool idle = m_CpuRenderer->Poll();
+	UploadCpuTiles();
+
+	if (idle)
+	{
+		UpdateResolution();
+		m_CpuRenderer->StartUpdate();
+		m_Frame++;
+	}
+}
+
+void FractalVisualizer::UploadCpuTiles()
+{
+	const auto tiles = m_CpuRenderer->TakeFinishedTiles();
+	if (tiles.empty())
+		return;
+
+	const glm::uvec2 size = m_CpuRenderer->GetSize();
+	const glm::vec4* samples = m_CpuRenderer->GetSamples().data();
+
+	glBindTexture(GL_TEXTURE_2D, m_Samples[0]);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, size.x);
+	for (const auto& tile : tiles)
+	{
+		glPixelStorei(GL_UNPACK_SKIP_PIXELS, tile.pos.x);
+		glPixelStorei(GL_UNPACK_SKIP_ROWS, tile.pos.y);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, tile.pos.x, tile.pos.y, tile.size.x, tile.size.y, GL_RGBA, GL_FLOAT, samples);
+	}
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+	glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+}
+
+void FractalVisualizer::Finish()
+{
+	if (m_Backend != Backend::Cpu || !m_CpuRenderer)
+		return;
+
+	m_CpuRenderer->Wait();
+	UploadCpuTiles();
+	m_ShouldResolve = true;
+	m_ShouldBuildHistogram = true;
+}
+
+void FractalVisualizer::SetDynamicResolution(bool dynamicResolution)
+{
+	if (m_DynamicResolution != dynamicResolution)
+	{
+		m_DynamicResolution = dynamicResolution;
+		ResetRender();
+	}
+}
+
+void FractalVisualizer::UpdateResolution()
+{
+	// Every pass halves the stride of the last one, down to every pixel
+	int level = 0;
+	if (m_DynamicResolution && !IsGuessing())
+		level = std::max(MaxResolutionLevel - m_Frame / ResolutionPassSteps, 0);
+
+	// The pixels added by the new pass start from the samples of their block.
+	// The CPU backend does the same with its own state.
+	if (m_Frame > 0 && level < m_ResolutionLevel && m_Backend != Backend::Cpu)
+	{
+		DrawCoarseFill();
+		glCopyImageSubData(m_CoarseFill->GetTexture(), GL_TEXTURE_2D, 0, 0, 0, 0, m_Samples[m_StateIndex], GL_TEXTURE_2D, 0, 0, 0, 0, m_Size.x, m_Size.y, 1);
+	}
+
+	m_ResolutionLevel = level;
+
+	if (m_Backend == Backend::Cpu)
+		m_CpuRenderer->SetStride(1u << level);
+}
+
+void FractalVisualizer::DrawCoarseFill()
+{
+	if (!m_CoarseFill)
+		m_CoarseFill = std::make_unique<CoarseFill>(m_QuadVA);
+
+	m_CoarseFill->Resize(m_Size);
+	m_CoarseFill->Draw(m_Samples[m_StateIndex], 1u << m_ResolutionLevel);
+}
+
+void FractalVisualizer::Resolve()
+{
+	if (!m_ShouldResolve)
+		return;
+	m_ShouldResolve = false;
+
+	const uint32_t stride = 1u << m_ResolutionLevel;
+
+	// The means move with every step, so the histogram follows them. It is
+	// built with the resolve, once for every image shown or saved, and not
+	// again when only the colors changed.
+	if (m_Equalize)
+	{
+		if (!m_Histogram)
+			m_Histogram = std::make_unique<IndexHistogram>();
+
+		if (m_ShouldBuildHistogram)
+			m_Histogram->Build(m_Samples[m_StateIndex], m_Size, stride);
+		else
+			m_Histogram->Bind(); // The other fractal may have bound its own
+
+		m_ShouldBuildHistogram = false;
+	}
+
+	m_Resolve->Draw(m_Samples[m_StateIndex], stride, m_SetColor);
+}
+
+void FractalVisualizer::SetPreview(bool preview)
+{
+	if (m_Previewing == preview || m_ShouldCreateFramebuffer)
+		return;
+
+	m_Previewing = preview;
+	if (preview)
+	{
+		if (!m_ZoomPreview)
+			m_ZoomPreview = std::make_unique<ZoomPreview>(m_QuadVA);
+
+		// If still fading in, the render of the last view is not full yet and
+		// the preview keeps reprojecting the one it started from
+		if (m_PreviewFade == 0)
+		{
+			m_ZoomPreview->Resize(m_Size);
+			m_ZoomPreview->Start(GetRenderTexture(), m_DeepCenter, m_Radius);
+		}
+	}
+	else
+		m_PreviewFade = PreviewFadeSteps;
+}
+
+void FractalVisualizer::UpdatePreview()
+{
+	float amount = PreviewBlend;
+	if (!m_Previewing)
+	{
+		// Fading into the render of the final view, all of it at the last step
+		m_PreviewFade--;
+		amount = 1.f - (float)m_PreviewFade / PreviewFadeSteps;
+	}
+
+	m_ZoomPreview->Blend(GetRenderTexture(), m_DeepCenter, m_Radius, amount);
+}
+
+void FractalVisualizer::SetRenderMode(RenderMode renderMode)
+{
+	if (m_RenderMode != renderMode)
+	{
+		m_RenderMode = renderMode;
+		ResetRender();
+	}
+}
+
+bool FractalVisualizer::IsGuessing() const
+{
+	return m_RenderMode == RenderMode::Guessing && m_Backend == Backend::Compute && !m_Perturbation;
+}
+
+bool FractalVisualizer::IsGuessingDone() const
+{
+	return !IsGuessing() || m_GuessTile == 1;
+}
+
+bool FractalVisualizer::HasRunSteps(int steps) const
+{
+	return IsGuessingDone() && m_Frame - m_GuessDoneFrame >= steps;
+}
+
+void FractalVisualizer::SetWorkGroupSize(uint32_t workGroupSize)
+{
+	if (m_WorkGroupSize != workGroupSize)
+	{
+		m_WorkGroupSize = workGroupSize;
+
+		if (m_Backend == Backend::Compute)
+		{
+			CompileShader();
+			ResetRender();
+		}
+	}
+}
+
+double FractalVisualizer::GetMinRadius() const
+{
+	// The CPU backend only has the double kernel
+	if (m_Backend == Backend::Cpu)
+		return 1e-15;
+
+	if (m_Perturbation)
+		return 1e-290;
+
+	switch (m_Precision)
+	{
+	case Precision::FloatFloat:   return 1e-13;
+	// The center and the pixels are two doubles that resolve them to 2^-107
+	// (~6e-33) near 1, about a third of a 1080p pixel at this radius
+	case Precision::DoubleDouble: return 1e-29;
+	default:                      return 1e-15;
+	}
+}
+
+void FractalVisualizer::SetJuliaC(const glm::dvec2& juliaC)
+{
+	if (m_JuliaC != juliaC)
+	{
+		m_JuliaC = juliaC;
+		m_ShouldUpdateReference = true;
+		ResetRender();
+	}
+}
+
 void FractalVisualizer::ResetRender()
 {
+	// Changes made after the preview ended are shown right away
+	if (!m_Previewing)
+		m_PreviewFade = 0;
+
 	m_Frame = 0;
+	m_GuessTile = 0;
+	m_GuessDoneFrame = 0;
+	m_ShouldRebuildActive = false;
+}
+
+void FractalVisualizer::UpdateReference()
+{
+	const double pixelSize = GetPixelSize();
+	const int limbs = BigFloat::LimbsForPixelSize(pixelSize);
+
+	// Distance from the center to the corners
+	const double viewRadius = pixelSize * glm::length(glm::dvec2(m_Size)) / 2.0;
+
+	if (m_DeepCenter.x.GetPrecision() < limbs)
+		m_DeepCenter.SetPrecision(limbs);
+
+	// The reference must be inside the view and precise enough for it
+	glm::dvec2 offset = (m_DeepCenter - m_ReferenceCenter).ToDouble();
+	if (m_ShouldUpdateReference || limbs > m_ReferencePrecision || glm::length(offset) > viewRadius)
+	{
+		m_ShouldUpdateReference = false;
+
+		GLint maxTexels;
+		glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+		const size_t maxLength = std::min(MaxReferenceLength, (size_t)maxTexels);
+
+		auto ComputeOrbit = [&](const BigComplex& point) {
+			if (m_IsJulia)
+				return ComputeReferenceOrbit(point, BigComplex(m_JuliaC, limbs), m_EqExponent, maxLength);
+			else
+				return ComputeReferenceOrbit(BigComplex({ 0.0, 0.0 }, limbs), point, m_EqExponent, maxLength);
+		};
+
+		m_ReferenceCenter = m_DeepCenter;
+		m_Reference.orbit = ComputeOrbit(m_ReferenceCenter);
+
+		// Pixels that outlive the reference lose the extra precision, so if
+		// the center escapes early look for a longer lived point in the view
+		for (int y = -2; y <= 2 && m_Reference.orbit.size() < maxLength; y++)
+		{
+			for (int x = -2; x <= 2 && m_Reference.orbit.size() < maxLength; x++)
+			{
+				if (x == 0 && y == 0)
+					continue;
+
+				BigComplex candidate = m_DeepCenter + BigComplex(glm::dvec2(x, y) * (viewRadius / 3.0), limbs);
+				auto orbit = ComputeOrbit(candidate);
+				if (orbit.size() > m_Reference.orbit.size())
+				{
+					m_Reference.orbit = std::move(orbit);
+					m_ReferenceCenter = candidate;
+				}
+			}
+		}
+		m_ReferencePrecision = limbs;
+
+		if (!m_ReferenceBuffer)
+		{
+			glGenBuffers(1, &m_ReferenceBuffer);
+			glGenTextures(1, &m_ReferenceTexture);
+		}
+
+		// Read as raw double bits by the shader
+		glBindBuffer(GL_TEXTURE_BUFFER, m_ReferenceBuffer);
+		glBufferData(GL_TEXTURE_BUFFER, m_Reference.orbit.size() * sizeof(glm::dvec2), m_Reference.orbit.data(), GL_STATIC_DRAW);
+
+		glBindTexture(GL_TEXTURE_BUFFER, m_ReferenceTexture);
+		glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32UI, m_ReferenceBuffer);
+
+		offset = (m_DeepCenter - m_ReferenceCenter).ToDouble();
+		m_Reference.seriesScale = 0.0;
+		ResetRender();
+	}
+
+	// The series depends on the size of the view. It has to bound the distance
+	// of every pixel to the reference, which is kept while it is up to
+	// viewRadius away from the center.
+	const double seriesScale = 2.0 * viewRadius;
+	if (m_Reference.seriesScale != seriesScale)
+		ComputeSeries(m_Reference, m_IsJulia, m_EqExponent, seriesScale);
+
+	m_ReferenceOffset = offset;
+}
+
+void FractalVisualizer::UpdateParams()
+{
+	static_assert(offsetof(ShaderParams, centerFF) == 160 && offsetof(ShaderParams, size) == 176 && sizeof(ShaderParams) == 224,
+		"ShaderParams must match the std140 layout of `FractalParams`");
+
+	auto [xRange, yRange] = GetRange();
+
+	// Center split in high and low parts for the extended precision kernels.
+	// The low part is tiny at any zoom, see BigFloat::ToDouble.
+	glm::dvec2 centerLo = (m_DeepCenter - BigComplex(m_Center, m_DeepCenter.x.GetPrecision())).ToDouble();
+	glm::vec2 centerHi = m_Center;
+	glm::vec4 centerFF = {
+		centerHi.x, (float)(m_Center.x - centerHi.x + centerLo.x),
+		centerHi.y, (float)(m_Center.y - centerHi.y + centerLo.y)
+	};
+
+	ShaderParams params = {};
+	params.xRange = xRange;
+	params.yRange = yRange;
+	params.juliaC = m_JuliaC;
+	params.refOffset = m_ReferenceOffset;
+	params.seriesA = m_Reference.seriesA;
+	params.seriesB = m_Reference.seriesB;
+	params.seriesC = m_Reference.seriesC;
+	params.center = m_Center;
+	params.centerLo = centerLo;
+	params.pixelSize = GetPixelSize();
+	params.seriesScale = m_Reference.seriesScale;
+	params.centerFF = centerFF;
+	params.itersPerFrame = m_IterationsPerFrame;
+	params.size = m_Size;
+	params.maxEpochs = m_MaxEpochs;
+	params.fadeThreshold = m_FadeThreshold;
+	params.refLength = (uint32_t)m_Reference.orbit.size();
+	params.seriesSkip = m_Reference.seriesSkip;
+	params.guessTile = IsGuessing() ? GuessTileSize : 0;
+	params.resolutionStride = 1u << m_ResolutionLevel;
+
+	if (m_ShouldUploadParams || std::memcmp(&params, &m_UploadedParams, sizeof(ShaderParams)) != 0)
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, m_ParamsUBO);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(ShaderParams), &params);
+
+		m_UploadedParams = params;
+		m_ShouldUploadParams = false;
+	}
+
+	// The binding point is shared with the other fractals
+	glBindBufferBase(GL_UNIFORM_BUFFER, ParamsBinding, m_ParamsUBO);
 }
 
 std::pair<glm::dvec2, glm::dvec2> FractalVisualizer::GetRange() const
@@ -308,68 +916,163 @@ glm::dvec2 FractalVisualizer::MapCoordsToPos(const ImVec2& coords) const
 	return ::MapCoordsToPos(m_Size, m_Radius, m_Center, coords);
 }
 
+glm::dvec2 FractalVisualizer::MapCoordsToOffset(const ImVec2& coords) const
+{
+	return
+	{
+		(coords.x - m_Size.x / 2.0) * GetPixelSize(),
+		(m_Size.y / 2.0 - coords.y) * GetPixelSize()
+	};
+}
+
 void FractalVisualizer::DeleteFramebuffer()
 {
-	glDeleteFramebuffers(1, &m_FBO);
+	glDeleteFramebuffers(IM_ARRAYSIZE(m_FBO), m_FBO);
+
+	glDeleteTextures(IM_ARRAYSIZE(m_Samples), m_Samples);
+	glDeleteTextures(IM_ARRAYSIZE(m_Data), m_Data);
+	glDeleteTextures(IM_ARRAYSIZE(m_Iter), m_Iter);
+	glDeleteTextures(IM_ARRAYSIZE(m_DataLo), m_DataLo);
+	glDeleteTextures(IM_ARRAYSIZE(m_Saved), m_Saved);
 
-	GLuint textures[] = { m_Texture, m_InData, m_OutData, m_InIter, m_OutIter };
-	glDeleteTextures(IM_ARRAYSIZE(textures), textures);
+	m_Samples[0] = m_Samples[1] = 0;
+	m_DataLo[0] = m_DataLo[1] = 0;
+	m_Saved[0] = m_Saved[1] = 0;
+}
+
+static GLuint CreateTexture(GLenum internalFormat, const glm::uvec2& size, GLint filter)
+{
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexStorage2D(GL_TEXTURE_2D, 1, internalFormat, size.x, size.y);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+	return texture;
 }
 
 void FractalVisualizer::CreateFramebuffer()
 {
-	glGenFramebuffers(1, &m_FBO);
-	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_FBO);
+	m_Resolve->Resize(m_Size);
+	m_ShouldResolve = true;
+	m_ShouldBuildHistogram = true;
+	m_StateIndex = 0;
+
+	// Nothing left to reproject
+	m_Previewing = false;
+	m_PreviewFade = 0;
+
+	// The CPU backend keeps its own state, only the samples are uploaded
+	if (m_Backend == Backend::Cpu)
+	{
+		m_Samples[0] = CreateTexture(GL_RGBA32F, m_Size, GL_NEAREST);
+		return;
+	}
 
-	// Main texture
-	glGenTextures(1, &m_Texture);
-	glBindTexture(GL_TEXTURE_2D, m_Texture);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_Size.x, m_Size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	// Double-double needs another 128 bits per pixel to store z
+	const bool dataLo = m_Precision == Precision::DoubleDouble && !m_Perturbation;
 
-	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_FBO);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_Texture, 0);
+	// The periodicity check keeps a saved z, not done by the perturbation kernel
+	const bool saved = !m_Perturbation;
 
-	// Out data
-	glGenTextures(1, &m_OutData);
-	glBindTexture(GL_TEXTURE_2D, m_OutData);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32UI, m_Size.x, m_Size.y, 0, GL_RGBA_INTEGER, GL_UNSIGNED_INT, nullptr);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glGenFramebuffers(IM_ARRAYSIZE(m_FBO), m_FBO);
+	for (int i = 0; i < IM_ARRAYSIZE(m_FBO); i++)
+	{
+		m_Samples[i] = CreateTexture(GL_RGBA32F, m_Size, GL_NEAREST);
+		m_Data[i] = CreateTexture(GL_RGBA32UI, m_Size, GL_NEAREST);
+		m_Iter[i] = CreateTexture(GL_RGBA32UI, m_Size, GL_NEAREST);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, m_FBO[i]);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_Samples[i], 0);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, m_Data[i], 0);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, m_Iter[i], 0);
+
+		if (dataLo)
+		{
+			m_DataLo[i] = CreateTexture(GL_RGBA32UI, m_Size, GL_NEAREST);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT3, GL_TEXTURE_2D, m_DataLo[i], 0);
+		}
+
+		if (saved)
+		{
+			m_Saved[i] = CreateTexture(GL_RGBA32UI, m_Size, GL_NEAREST);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT4, GL_TEXTURE_2D, m_Saved[i], 0);
+		}
+
+		GLenum bufs[] = {
+			GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2,
+			dataLo ? GL_COLOR_ATTACHMENT3 : GL_NONE,
+			saved ? GL_COLOR_ATTACHMENT4 : GL_NONE
+		};
+		glDrawBuffers(IM_ARRAYSIZE(bufs), bufs);
+
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		{
+			LOG_ERROR("Failed to create fractal framebuffer ({0}, {1})", m_Size.x, m_Size.y);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	if (m_Backend == Backend::Compute)
+	{
+		if (!m_ActivePixels)
+			m_ActivePixels = std::make_unique<ActivePixelList>();
+		m_ActivePixels->Resize(m_Size);
+	}
+}
 
-	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_FBO);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, m_OutData, 0);
+void FractalVisualizer::ShiftState(const glm::ivec2& shift)
+{
+	if (m_Backend == Backend::Cpu)
+	{
+		m_CpuRenderer->Shift(shift, m_Center);
+		return;
+	}
 
-	// Out iter
-	glGenTextures(1, &m_OutIter);
-	glBindTexture(GL_TEXTURE_2D, m_OutIter);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32UI, m_Size.x, m_Size.y, 0, GL_RG_INTEGER, GL_UNSIGNED_INT, nullptr);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	// Same as PIXEL_START in the shaders
+	constexpr GLuint PixelStart = 8;
 
-	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_FBO);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, m_OutIter, 0);
+	const glm::ivec2 size = m_Size;
+	const glm::ivec2 src = glm::max(shift, 0);
+	const glm::ivec2 dst = glm::max(-shift, 0);
+	const glm::ivec2 extent = size - glm::abs(shift);
 
-	glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
-	GLenum bufs[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
-	glDrawBuffers(IM_ARRAYSIZE(bufs), bufs);
+	// The compute backend wrote the state from shaders
+	if (m_Backend == Backend::Compute)
+		glMemoryBarrier(GL_ALL_BARRIER_BITS);
 
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	// Into the other set, as if it was a step
+	const int read = m_StateIndex;
+	const int write = 1 - m_StateIndex;
+	for (GLuint* textures : { m_Samples, m_Data, m_Iter, m_DataLo, m_Saved })
 	{
-		LOG_ERROR("Failed to create fractal framebuffer ({0}, {1})", m_Size.x, m_Size.y);
-		exit(EXIT_FAILURE);
+		if (textures[read])
+			glCopyImageSubData(textures[read], GL_TEXTURE_2D, 0, src.x, src.y, 0, textures[write], GL_TEXTURE_2D, 0, dst.x, dst.y, 0, extent.x, extent.y, 1);
 	}
 
-	glGenTextures(1, &m_InData);
-	glBindTexture(GL_TEXTURE_2D, m_InData);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32UI, m_Size.x, m_Size.y, 0, GL_RGBA_INTEGER, GL_UNSIGNED_INT, nullptr);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	// The strips that came into view restart on the next step
+	const glm::ivec4 strips[] = {
+		{ shift.x > 0 ? extent.x : 0, 0, std::abs(shift.x), size.y },
+		{ 0, shift.y > 0 ? extent.y : 0, size.x, std::abs(shift.y) }
+	};
+
+	const GLuint start[4] = { 0, 0, 0, PixelStart };
+	const GLfloat noSamples[4] = { 0.f, 0.f, 0.f, 0.f };
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_FBO[write]);
+	glEnable(GL_SCISSOR_TEST);
+	for (const auto& strip : strips)
+	{
+		if (strip.z == 0 || strip.w == 0)
+			continue;
+
+		glScissor(strip.x, strip.y, strip.z, strip.w);
+		glClearBufferfv(GL_COLOR, 0, noSamples);
+		glClearBufferuiv(GL_COLOR, 2, start);
+	}
+	glDisable(GL_SCISSOR_TEST);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-	glGenTextures(1, &m_InIter);
-	glBindTexture(GL_TEXTURE_2D, m_InIter);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32UI, m_Size.x, m_Size.y, 0, GL_RG_INTEGER, GL_UNSIGNED_INT, nullptr);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	m_StateIndex = write;
+	m_ShouldRebuildActive = true;
 }
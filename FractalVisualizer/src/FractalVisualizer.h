@@ -5,21 +5,73 @@
 #include <filesystem>
 
 #include "ColorFunction.h"
+#include "BigFloat.h"
+#include "Perturbation.h"
+#include "ActivePixelList.h"
+#include "MarianiSilver.h"
+#include "CpuRenderer.h"
+#include "ZoomPreview.h"
+#include "CoarseFill.h"
+#include "ColorResolve.h"
+#include "IndexHistogram.h"
 
 std::pair<glm::dvec2, glm::dvec2> GetRange(const glm::uvec2& resolution, double radius, const glm::dvec2& center);
 ImVec2 MapPosToCoords(const glm::uvec2& resolution, double radius, const glm::dvec2& center, const glm::dvec2& pos);
 glm::dvec2 MapCoordsToPos(const glm::uvec2& resolution, double radius, const glm::dvec2& center, const ImVec2& coords);
 
+// Arithmetic of the regular (non perturbation) kernel
+enum class Precision
+{
+	Double = 0,
+	FloatFloat,   // Pairs of floats, ~1e-13 at fp32 speed
+	DoubleDouble  // Pairs of doubles, ~1e-29
+};
+
+// How the iteration step is run
+enum class Backend
+{
+	Fragment = 0, // Fullscreen quad, ping-ponging the state between framebuffers
+	Compute,      // Compute shader updating the state in place (GL 4.3)
+	Cpu           // SIMD kernels on the CPU, only the regular double kernel, see CpuRenderer
+};
+
+// Which pixels get iterated
+enum class RenderMode
+{
+	Full = 0, // Every pixel
+	Guessing  // Solid areas are filled from their border, see MarianiSilver
+};
+
 class FractalVisualizer
 {
 public:
 	FractalVisualizer(std::filesystem::path shaderSrcPath);
 	~FractalVisualizer();
 
+	// Runs one step. The CPU backend steps in the background, the calls made
+	// while it is busy only show the tiles finished so far.
 	void Update();
 
+	// Waits for the step started by the last Update, for when every Update has
+	// to be a whole step
+	void Finish();
+
+	// Takes the render settings of `other`: everything but the view, the size,
+	// the color function and the julia c, which renders of a copy pick
+	void CopySettings(const FractalVisualizer& other);
+
 	void SetCenter(const glm::dvec2& center);
+	void SetDeepCenter(const BigComplex& center);
 	glm::dvec2 GetCenter() const { return m_Center; }
+	const BigComplex& GetDeepCenter() const { return m_DeepCenter; }
+
+	// Moves the center keeping all the precision of the deep center
+	void MoveCenter(const glm::dvec2& offset);
+
+	// Drags the view by `delta` image pixels (y down, like MapCoordsToOffset).
+	// The movement is snapped to whole pixels and the pixels still in view
+	// keep their progress, only the newly exposed ones start from scratch.
+	void Pan(const ImVec2& delta);
 
 	void SetRadius(double radius);
 	double GetRadius() const { return m_Radius; }
@@ -29,12 +81,20 @@ public:
 
 	void SetShader(std::filesystem::path shaderSrcPath);
 
+	// The set and color function only change how the render is resolved, the
+	// pixels keep going from where they are
 	void SetSetColor(const glm::vec3& setColor);
 	glm::vec3 GetSetColor() const { return m_SetColor; };
 
 	void SetColorFunction(const std::shared_ptr<ColorFunction>& colorFunc);
 	std::shared_ptr<ColorFunction> GetColorFunction() const { return m_ColorFunction; }
 
+	// Colors by the rank of the index among the pixels in view instead of the
+	// index itself, see IndexHistogram. Also only changes the resolve.
+	void SetEqualize(bool equalize);
+	bool GetEqualize() const { return m_Equalize; }
+
+	// Does not start over, the pixels go on from where they are
 	void SetIterationsPerFrame(int iterationsPerFrame);
 	int GetIterationsPerFrame() const { return m_IterationsPerFrame; }
 
@@ -50,24 +110,160 @@ public:
 	void SetEqExponent(int eqExponent);
 	int GetEqExponent() const { return m_EqExponent; }
 
+	// Iterates the difference to a high precision reference orbit, which allows
+	// zooming way past the double precision limit
+	void SetPerturbation(bool perturbation);
+	bool GetPerturbation() const { return m_Perturbation; }
+
+	void SetPrecision(Precision precision);
+	Precision GetPrecision() const { return m_Precision; }
+
+	// Smallest radius the current kernel can resolve
+	double GetMinRadius() const;
+
+	void SetBackend(Backend backend);
+	Backend GetBackend() const { return m_Backend; }
+
+	// Only used by the compute backend
+	void SetWorkGroupSize(uint32_t workGroupSize);
+	uint32_t GetWorkGroupSize() const { return m_WorkGroupSize; }
+
+	// Guessing needs the compute backend and is ignored by the perturbation kernel
+	void SetRenderMode(RenderMode renderMode);
+	RenderMode GetRenderMode() const { return m_RenderMode; }
+
+	// Guessed and computed pixels of the last render, valid once IsGuessingDone
+	MarianiSilver::Stats GetGuessStats() const { return m_GuessStats; }
+
+	// Also true when not guessing, no pixel is left pending
+	bool IsGuessingDone() const;
+
+	// Whether every pixel had `steps` steps of its own. The pixels the guessing
+	// leaves to compute start with the refinement that found them, so with it
+	// the render takes longer than `steps` to get there.
+	bool HasRunSteps(int steps) const;
+
+	// Only used by the julia shader
+	void SetJuliaC(const glm::dvec2& juliaC);
+	glm::dvec2 GetJuliaC() const { return m_JuliaC; }
+
 	//void SetUniform()
 	GLuint GetShader() const { return m_Shader; }
 
 	// Starts calculating from scratch
 	void ResetRender();
 
-	GLuint GetTexture() const { return m_Texture; }
+	// Steps run since the render started
+	int GetFrame() const { return m_Frame; }
+
+	// While previewing, and for a few steps after, the image shown is the one
+	// of the preview. Colors the samples first if they changed, so the resolve
+	// runs once for every image shown or saved instead of once every step.
+	GLuint GetTexture() { return m_Previewing || m_PreviewFade > 0 ? m_ZoomPreview->GetTexture() : GetRenderTexture(); }
+
+	// Full screen quad of the passes that work on the image, see YuvConvert
+	GLuint GetQuadVA() const { return m_QuadVA; }
+
+	// While on, view changes keep showing the last full render, reprojected
+	// to the new view, and only its first step is run. The new samples are
+	// blended over it. Once off, the render of the final view runs as usual and the
+	// image fades into it.
+	void SetPreview(bool preview);
+	bool IsPreviewing() const { return m_Previewing; }
+
+	// Every render starts computing only one pixel out of each block of
+	// 2^MaxResolutionLevel, the rest show the color of their block. Every
+	// ResolutionPassSteps steps the blocks are halved, the pixels already
+	// computed keep going and the new ones start from the color of their
+	// block, until every pixel is computed. Views that change every frame
+	// stay at the coarsest pass. Ignored while guessing.
+	void SetDynamicResolution(bool dynamicResolution);
+	bool GetDynamicResolution() const { return m_DynamicResolution; }
 
 	ImVec2 MapPosToCoords(const glm::dvec2& pos) const;
 	glm::dvec2 MapCoordsToPos(const ImVec2& coords) const;
 
+	// Offset from the center, valid at any zoom level
+	glm::dvec2 MapCoordsToOffset(const ImVec2& coords) const;
+	double GetPixelSize() const { return 2.0 * m_Radius / m_Size.y; }
+
 	std::pair<glm::dvec2, glm::dvec2> GetRange() const;
 
+	// Uniform buffer binding points shared by all the fractal shaders
+	static constexpr GLuint ParamsBinding = 0;
+
+	// Longest reference orbit, pixels that outlive it rebase to its start
+	static constexpr size_t MaxReferenceLength = 100000;
+
+	// Steps between rebuilds of the active pixel list of the compute backend
+	static constexpr int CompactionInterval = 8;
+
+	// Steps run for every view while previewing
+	static constexpr int PreviewSteps = 1;
+
+	// Weight of the new samples in the preview image
+	static constexpr float PreviewBlend = 0.25f;
+
+	// Steps taken to fade from the preview into the render once it ends
+	static constexpr int PreviewFadeSteps = 8;
+
+	// Coarsest pass of the dynamic resolution, one pixel out of 8x8
+	static constexpr int MaxResolutionLevel = 3;
+
+	// Steps of every pass of the dynamic resolution but the last
+	static constexpr int ResolutionPassSteps = 2;
+
+	// Coarsest tile of the guessing, halved at every rebuild down to single pixels
+	static constexpr uint32_t GuessTileSize = 32;
+
+	// Steps between refinements, the active pixel list is rebuilt after each one
+	static constexpr int GuessInterval = 2;
+
 private:
 
 	void DeleteFramebuffer();
 	void CreateFramebuffer();
 
+	// Builds the iteration program for the current kernel, backend and the
+	// features that are baked in. The state stays, the callers that change
+	// what it holds reset the render.
+	void CompileShader();
+
+	// Moves the deep center without starting over
+	void OffsetCenter(const glm::dvec2& offset);
+
+	// Moves the iteration state and the samples so that every pixel reads the
+	// one `shift` pixels away (y up), the pixels left outside restart
+	void ShiftState(const glm::ivec2& shift);
+
+	// Uploads the fractal parameters if any of them changed since the last step
+	void UpdateParams();
+
+	// Picks a new reference orbit if the current one is not valid for the view
+	void UpdateReference();
+
+	// Starts a step of the CPU backend when the last one is done and uploads
+	// the tiles finished since the last call
+	void UpdateCpu();
+	void UploadCpuTiles();
+
+	// Runs a step of the fragment or compute backend
+	void UpdateGpu();
+
+	// Blends the last step into the preview image
+	void UpdatePreview();
+
+	// Picks the pass of the dynamic resolution for the next step
+	void UpdateResolution();
+	void DrawCoarseFill();
+
+	// Colors the samples if they changed since the last resolve, see ColorResolve
+	void Resolve();
+
+	GLuint GetRenderTexture() { Resolve(); return m_Resolve->GetTexture(); }
+
+	bool IsGuessing() const;
+
 	// Shoulds
 	bool m_ShouldCreateFramebuffer = true;
 
@@ -84,17 +280,101 @@ private:
 	int m_FadeThreshold = 0;
 
 	int m_EqExponent = 2;
+	glm::dvec2 m_JuliaC = { 0.0, 0.0 };
+
+	Precision m_Precision = Precision::Double;
+	Backend m_Backend = Backend::Fragment;
+	uint32_t m_WorkGroupSize = 64;
+	RenderMode m_RenderMode = RenderMode::Full;
+
+	// Perturbation
+	bool m_Perturbation = false;
+	bool m_IsJulia = false;
+	bool m_ShouldUpdateReference = true;
+	BigComplex m_DeepCenter;
+	BigComplex m_ReferenceCenter;
+	int m_ReferencePrecision = 0;
+	glm::dvec2 m_ReferenceOffset = { 0.0, 0.0 };
+	ReferenceOrbit m_Reference;
+	GLuint m_ReferenceBuffer = 0;
+	GLuint m_ReferenceTexture = 0;
 
 	std::shared_ptr<ColorFunction> m_ColorFunction;
 
 	// Shader
 	std::string m_ShaderSrc;
 	GLuint m_Shader = 0;
+	GLint m_FrameLocation = -1;
+
+	// Mirrors the std140 `FractalParams` block of the fractal shaders
+	struct ShaderParams
+	{
+		glm::dvec2 xRange;
+		glm::dvec2 yRange;
+		glm::dvec2 juliaC;
+		glm::dvec2 refOffset;
+		glm::dvec2 seriesA;
+		glm::dvec2 seriesB;
+		glm::dvec2 seriesC;
+		glm::dvec2 center;
+		glm::dvec2 centerLo;
+		double pixelSize;
+		double seriesScale;
+		glm::vec4 centerFF;
+		glm::uvec2 size;
+		uint32_t itersPerFrame;
+		uint32_t maxEpochs;
+		uint32_t fadeThreshold;
+		uint32_t refLength;
+		uint32_t seriesSkip;
+		uint32_t guessTile;
+		uint32_t resolutionStride;
+		uint32_t padding[3]; // std140 rounds the block up to a multiple of 16 bytes
+	};
+
+	GLuint m_ParamsUBO = 0;
+	ShaderParams m_UploadedParams;
+	bool m_ShouldUploadParams = true;
 
 	// Drawing stuff
-	GLuint m_FBO, m_Texture;
-	GLuint m_InData, m_OutData;
-	GLuint m_InIter, m_OutIter;
 	GLuint m_QuadVA, m_QuadVB, m_QuadIB;
+	std::unique_ptr<ColorResolve> m_Resolve;
+	bool m_ShouldResolve = true;
+
+	bool m_Equalize = false;
+	std::unique_ptr<IndexHistogram> m_Histogram; // Rebuilt before the resolves of new samples while equalizing
+	bool m_ShouldBuildHistogram = true;
+
+	// Iteration state is double buffered. Each step reads the set at
+	// `m_StateIndex` and writes the other one, then they swap roles.
+	GLuint m_FBO[2] = {};
+	GLuint m_Samples[2] = {}; // The CPU backend only uploads to the first one
+	GLuint m_Data[2] = {};
+	GLuint m_Iter[2] = {};
+	GLuint m_DataLo[2] = {}; // Only for double-double
+	GLuint m_Saved[2] = {};  // Not for perturbation
+	int m_StateIndex = 0;
+
+	// Pan not applied yet, less than a pixel
+	glm::dvec2 m_PanRemainder = { 0.0, 0.0 };
+
+	std::unique_ptr<ZoomPreview> m_ZoomPreview;
+	bool m_Previewing = false;
+	int m_PreviewFade = 0; // Steps left until the render is shown again
+
+	bool m_DynamicResolution = false;
+	int m_ResolutionLevel = 0; // Only every 2^level-th pixel is computed
+	std::unique_ptr<CoarseFill> m_CoarseFill;
+
+	// Only for the compute backend
+	std::unique_ptr<ActivePixelList> m_ActivePixels;
+	bool m_ShouldRebuildActive = false;
+	std::unique_ptr<MarianiSilver> m_Guessing;
+	uint32_t m_GuessTile = 0; // Tile size of the next refinement
+	int m_GuessDoneFrame = 0; // Step that started the pixels of the last refinement
+	MarianiSilver::Stats m_GuessStats;
+
+	// Only for the CPU backend
+	std::unique_ptr<CpuRenderer> m_CpuRenderer;
 };
 
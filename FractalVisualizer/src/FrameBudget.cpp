@@ -0,0 +1,85 @@
+#include "FrameBudget.h"
+
+FrameBudget::FrameBudget()
+{
+	for (auto& query : m_Queries)
+		glGenQueries(1, &query.id);
+}
+
+FrameBudget::~FrameBudget()
+{
+	for (auto& query : m_Queries)
+		glDeleteQueries(1, &query.id);
+}
+
+void FrameBudget::Run(FractalVisualizer& fract, double budget)
+{
+	ReadResults(budget);
+
+	// A new render starts with every pixel active again
+	if (fract.GetFrame() == 0 && (double)m_Steps * m_Iterations > m_FreshWork)
+		SetWork(m_FreshWork);
+
+	fract.SetIterationsPerFrame(m_Iterations);
+
+	// If every query is still in flight the frame goes untimed
+	Query& query = m_Queries[m_Next];
+	if (!query.pending)
+		glBeginQuery(GL_TIME_ELAPSED, query.id);
+
+	const int first = fract.GetFrame();
+	for (int i = 0; i < m_Steps; i++)
+		fract.Update();
+	const int last = fract.GetFrame();
+
+	if (!query.pending)
+	{
+		glEndQuery(GL_TIME_ELAPSED);
+
+		// Only the steps actually run count, none while previewing
+		query.pending = true;
+		query.fresh = first < FreshSteps || last < first;
+		query.steps = last >= first ? last - first : last;
+		query.iterations = m_Iterations;
+
+		m_Next = (m_Next + 1) % QueryCount;
+	}
+}
+
+void FrameBudget::ReadResults(double budget)
+{
+	// From the oldest, the ones after an unavailable one are not available either
+	for (int i = 0; i < QueryCount; i++)
+	{
+		Query& query = m_Queries[(m_Next + i) % QueryCount];
+		if (!query.pending)
+			continue;
+
+		GLint available = 0;
+		glGetQueryObjectiv(query.id, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			break;
+
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64v(query.id, GL_QUERY_RESULT, &elapsed);
+		query.pending = false;
+
+		if (query.steps == 0)
+			continue;
+
+		m_Time = elapsed / 1e6;
+
+		const double work = (double)query.steps * query.iterations;
+		const double scale = std::clamp(budget / std::max(m_Time, 1e-3), 1.0 / MaxChange, MaxChange);
+		if (query.fresh)
+			m_FreshWork = work * scale;
+
+		SetWork(work * scale);
+	}
+}
+
+void FrameBudget::SetWork(double work)
+{
+	m_Steps = std::clamp((int)std::ceil(work / MaxIterations), 1, MaxSteps);
+	m_Iterations = std::clamp((int)(work / m_Steps), MinIterations, MaxIterations);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <GLCore.h>
+
+#include "FractalVisualizer.h"
+
+// Picks the iterations per step and steps per frame of a fractal so that its
+// steps take a given time on the GPU. The steps of every frame are timed with
+// a query whose result is read a few frames later, so the CPU never waits for
+// the GPU. The work of a frame is scaled by how far its time was from the
+// budget, using long steps first and more of them only once they are as long
+// as they go.
+//
+// The work a fresh render can take, with every pixel still active, is kept
+// apart: once pixels finish the same time fits a lot more work, which would
+// stall the next render.
+class FrameBudget
+{
+public:
+	FrameBudget();
+	~FrameBudget();
+
+	FrameBudget(const FrameBudget&) = delete;
+	FrameBudget& operator=(const FrameBudget&) = delete;
+
+	// Runs the steps of this frame, `budget` in milliseconds. Not for the CPU
+	// backend, its steps run in the background.
+	void Run(FractalVisualizer& fract, double budget);
+
+	int GetIterations() const { return m_Iterations; }
+	int GetSteps() const { return m_Steps; }
+
+	// GPU time of the last frame measured, in milliseconds
+	double GetTime() const { return m_Time; }
+
+	// Same limits as the controls
+	static constexpr int MinIterations = 10;
+	static constexpr int MaxIterations = 10000;
+	static constexpr int MaxSteps = 100;
+
+	// Most the work can change from one frame to the next
+	static constexpr double MaxChange = 2.0;
+
+	// Steps of a render that count as fresh
+	static constexpr int FreshSteps = 4;
+
+	// Frames a result can be waited for
+	static constexpr int QueryCount = 4;
+
+private:
+	struct Query
+	{
+		GLuint id = 0;
+		bool pending = false;
+		bool fresh = false;
+		int steps = 0;
+		int iterations = 0;
+	};
+
+	void ReadResults(double budget);
+	void SetWork(double work);
+
+	Query m_Queries[QueryCount];
+	int m_Next = 0;
+
+	int m_Iterations = 100;
+	int m_Steps = 1;
+	double m_FreshWork = 100.0; // Iterations per pixel a fresh render can take
+	double m_Time = 0.0;
+};
@@ -0,0 +1,162 @@
+#include "FramePipe.h"
+
+#include <cstring>
+
+#ifndef _WIN32
+#define _popen popen
+#define _pclose pclose
+#endif
+
+FramePipe::~FramePipe()
+{
+	if (IsOpen())
+		Close();
+}
+
+bool FramePipe::Open(const std::string& command, size_t frameSize)
+{
+#ifdef _WIN32
+	m_Pipe = _popen(command.c_str(), "wb");
+#else
+	m_Pipe = _popen(command.c_str(), "w");
+#endif
+	if (!m_Pipe)
+		return false;
+
+	m_FrameSize = frameSize;
+	m_Next = 0;
+	m_Closing = false;
+	m_Failed = false;
+
+	m_Ring.resize(ReadbackDepth);
+	for (Readback& slot : m_Ring)
+	{
+		glGenBuffers(1, &slot.buffer);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+		glBufferData(GL_PIXEL_PACK_BUFFER, frameSize, nullptr, GL_STREAM_READ);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	m_Spare.assign(QueueDepth, std::vector<uint8_t>(frameSize));
+
+	m_Writer = std::thread(&FramePipe::Write, this);
+	return true;
+}
+
+void FramePipe::Push(GLuint texture, GLenum format, GLenum type)
+{
+	// The oldest frame has had the time of the whole ring to finish
+	Readback& slot = m_Ring[m_Next++ % m_Ring.size()];
+	if (slot.fence)
+		Retire(slot);
+
+	// Rows of single byte formats are not padded to 4 in the frame
+	GLint alignment;
+	glGetIntegerv(GL_PACK_ALIGNMENT, &alignment);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glGetTexImage(GL_TEXTURE_2D, 0, format, type, nullptr);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	glPixelStorei(GL_PACK_ALIGNMENT, alignment);
+
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void FramePipe::Retire(Readback& slot)
+{
+	// Back-pressure, the renderer waits for the writer here
+	std::vector<uint8_t> frame;
+	{
+		std::unique_lock lock(m_Mutex);
+		m_Freed.wait(lock, [&] { return !m_Spare.empty(); });
+		frame = std::move(m_Spare.back());
+		m_Spare.pop_back();
+	}
+
+	// The flush makes sure the fence gets to the GPU at all
+	while (glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000'000) == GL_TIMEOUT_EXPIRED);
+	glDeleteSync(slot.fence);
+	slot.fence = nullptr;
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+	if (const void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, m_FrameSize, GL_MAP_READ_BIT))
+	{
+		std::memcpy(frame.data(), data, m_FrameSize);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	{
+		std::lock_guard lock(m_Mutex);
+		m_Frames.push_back(std::move(frame));
+	}
+	m_Queued.notify_one();
+}
+
+void FramePipe::Write()
+{
+	while (true)
+	{
+		std::vector<uint8_t> frame;
+		{
+			std::unique_lock lock(m_Mutex);
+			m_Queued.wait(lock, [&] { return m_Closing || !m_Frames.empty(); });
+			if (m_Frames.empty())
+				return;
+
+			frame = std::move(m_Frames.front());
+			m_Frames.pop_front();
+		}
+
+		// After a failure the frames are only drained, so Push never waits forever
+		bool written = m_Failed || fwrite(frame.data(), frame.size(), 1, m_Pipe) == 1;
+
+		{
+			std::lock_guard lock(m_Mutex);
+			if (!written && !m_Failed)
+			{
+				LOG_ERROR("Failed to write a frame to the pipe");
+				m_Failed = true;
+			}
+			m_Spare.push_back(std::move(frame));
+		}
+		m_Freed.notify_one();
+	}
+}
+
+bool FramePipe::HasFailed() const
+{
+	std::lock_guard lock(m_Mutex);
+	return m_Failed;
+}
+
+bool FramePipe::Close()
+{
+	// Oldest first, the frames must keep their order
+	for (size_t i = 0; i < m_Ring.size(); i++)
+	{
+		Readback& slot = m_Ring[(m_Next + i) % m_Ring.size()];
+		if (slot.fence)
+			Retire(slot);
+	}
+
+	{
+		std::lock_guard lock(m_Mutex);
+		m_Closing = true;
+	}
+	m_Queued.notify_one();
+	m_Writer.join();
+
+	const int status = _pclose(m_Pipe);
+	m_Pipe = nullptr;
+
+	for (Readback& slot : m_Ring)
+		glDeleteBuffers(1, &slot.buffer);
+	m_Ring.clear();
+	m_Spare.clear();
+
+	return !m_Failed && status == 0;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <GLCore.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Pipes frames read back from textures into the stdin of a command, without
+// the renderer waiting on either of them. Every frame is copied into a ring of
+// pixel pack buffers and only mapped a few frames later, once its fence has
+// signaled. Mapped frames go through a bounded queue to a thread that owns the
+// pipe. When the command falls behind and the queue fills, Push blocks until
+// the writer frees a slot.
+class FramePipe
+{
+public:
+	FramePipe() = default;
+	~FramePipe();
+
+	FramePipe(const FramePipe&) = delete;
+	FramePipe& operator=(const FramePipe&) = delete;
+
+	// Starts `command`, taking frames of `frameSize` bytes
+	bool Open(const std::string& command, size_t frameSize);
+
+	// Queues the read back of the texture and returns before it is done
+	void Push(GLuint texture, GLenum format, GLenum type);
+
+	// Writes the frames still in flight and waits for the command to exit.
+	// False if a write failed or the command reported an error.
+	bool Close();
+
+	bool IsOpen() const { return m_Pipe != nullptr; }
+
+	// A write failed, the frames pushed from then on are dropped
+	bool HasFailed() const;
+
+private:
+	struct Readback
+	{
+		GLuint buffer = 0;
+		GLsync fence = nullptr;
+	};
+
+	// Hands the frame of the slot to the writer
+	void Retire(Readback& slot);
+	void Write();
+
+	static constexpr size_t ReadbackDepth = 3;
+	static constexpr size_t QueueDepth = 3;
+
+	FILE* m_Pipe = nullptr;
+	size_t m_FrameSize = 0;
+
+	std::vector<Readback> m_Ring;
+	size_t m_Next = 0;
+
+	std::thread m_Writer;
+	mutable std::mutex m_Mutex;
+	std::condition_variable m_Queued; // A frame is waiting or the pipe closes
+	std::condition_variable m_Freed;  // A frame was written
+	std::deque<std::vector<uint8_t>> m_Frames;
+	std::vector<std::vector<uint8_t>> m_Spare;
+	bool m_Closing = false;
+	bool m_Failed = false;
+};
@@ -0,0 +1,253 @@
+#include "IndexHistogram.h"
+#include "ComputeShader.h"
+
+#include <format>
+
+// Shared with the shaders that read the histogram
+static const char* s_CommonSrc = R"(
+layout (std430, binding = HISTOGRAM_BINDING) buffer IndexHistogram
+{
+    uint range_keys[2]; // Smallest and largest index, see index_key
+    uint total;
+    uint pad;
+    uint counts[BINS];
+    float cdf[BINS + 1]; // Fraction of the pixels below every bin boundary
+};
+
+// Orders like the float, so the range can be found with atomics
+uint index_key(float index)
+{
+    uint bits = floatBitsToUint(index);
+    return (bits & 0x80000000u) != 0 ? ~bits : bits | 0x80000000u;
+}
+
+float key_index(uint key)
+{
+    return uintBitsToFloat((key & 0x80000000u) != 0 ? key & 0x7FFFFFFFu : ~key);
+}
+
+// Position of `index` in the bins, from 0 to BINS. Most pixels escape close to
+// the smallest index and a few last much longer, so the bins grow
+// logarithmically from it.
+float histogram_position(float index)
+{
+    float lo = key_index(range_keys[0]);
+    float hi = key_index(range_keys[1]);
+    float x = log2(1.0 + max(index - lo, 0.0)) / max(log2(1.0 + hi - lo), 1e-6);
+    return clamp(x * float(BINS), 0.0, float(BINS));
+}
+
+float equalize(float index)
+{
+    if (total == 0)
+        return 0.0;
+
+    float x = histogram_position(index);
+    uint bin = min(uint(x), BINS - 1);
+    return mix(cdf[bin], cdf[bin + 1], x - float(bin));
+}
+)";
+
+// The three passes of the build, selected with a define:
+//  RANGE:  smallest and largest index of the covered pixels
+//  COUNT:  covered pixels in every bin between them
+//  SCAN:   prefix sum of the bins, normalized into the cdf
+static const char* s_BuildSrc = R"(
+#if defined(SCAN)
+layout (local_size_x = SCAN_GROUP_SIZE) in;
+#else
+layout (local_size_x = 16, local_size_y = 16) in;
+#endif
+
+// (mean, variance, coverage, 0) of the color index, see add_sample in the fractal shaders
+layout (binding = 0) uniform sampler2D i_Samples;
+
+layout (location = 0) uniform uvec2 i_Size;
+layout (location = 1) uniform uint i_Stride;
+
+// Every invocation looks at one shown pixel
+bool load_index(out float index)
+{
+    uvec2 p = gl_GlobalInvocationID.xy * i_Stride;
+    if (any(greaterThanEqual(p, i_Size)))
+        return false;
+
+    vec4 samples = texelFetch(i_Samples, ivec2(p), 0);
+    index = samples.x;
+    return samples.z > 0.0;
+}
+
+#if defined(RANGE)
+shared uint s_Range[2];
+
+void main()
+{
+    if (gl_LocalInvocationIndex == 0)
+    {
+        s_Range[0] = 0xFFFFFFFFu;
+        s_Range[1] = 0u;
+    }
+    barrier();
+
+    float index;
+    if (load_index(index))
+    {
+        uint key = index_key(index);
+        atomicMin(s_Range[0], key);
+        atomicMax(s_Range[1], key);
+    }
+    barrier();
+
+    // Only the groups that saw a covered pixel
+    if (gl_LocalInvocationIndex == 0 && s_Range[0] <= s_Range[1])
+    {
+        atomicMin(range_keys[0], s_Range[0]);
+        atomicMax(range_keys[1], s_Range[1]);
+    }
+}
+#elif defined(COUNT)
+#define GROUP_PIXELS 256u
+
+// Counted per work group first, the global bins only get one atomic each
+shared uint s_Counts[BINS];
+
+void main()
+{
+    for (uint b = gl_LocalInvocationIndex; b < BINS; b += GROUP_PIXELS)
+        s_Counts[b] = 0;
+    barrier();
+
+    float index;
+    if (load_index(index))
+        atomicAdd(s_Counts[min(uint(histogram_position(index)), BINS - 1)], 1u);
+    barrier();
+
+    for (uint b = gl_LocalInvocationIndex; b < BINS; b += GROUP_PIXELS)
+    {
+        if (s_Counts[b] != 0)
+            atomicAdd(counts[b], s_Counts[b]);
+    }
+}
+#elif defined(SCAN)
+shared uint s_Scan[SCAN_GROUP_SIZE];
+
+// Inclusive scan over the work group, see ActivePixelList
+uint group_scan(uint value)
+{
+    uint id = gl_LocalInvocationID.x;
+    s_Scan[id] = value;
+    barrier();
+
+    for (uint offset = 1; offset < SCAN_GROUP_SIZE; offset <<= 1)
+    {
+        uint other = id >= offset ? s_Scan[id - offset] : 0;
+        barrier();
+        s_Scan[id] += other;
+        barrier();
+    }
+
+    return s_Scan[id];
+}
+
+void main()
+{
+    // A single work group, each invocation takes a contiguous chunk of bins
+    const uint chunk = BINS / SCAN_GROUP_SIZE;
+    uint first = gl_LocalInvocationID.x * chunk;
+
+    uint sum = 0;
+    for (uint b = first; b < first + chunk; b++)
+        sum += counts[b];
+
+    uint offset = group_scan(sum) - sum;
+    uint covered = s_Scan[SCAN_GROUP_SIZE - 1];
+
+    float scale = covered > 0 ? 1.0 / float(covered) : 0.0;
+    for (uint b = first; b < first + chunk; b++)
+    {
+        offset += counts[b];
+        cdf[b + 1] = float(offset) * scale;
+    }
+
+    if (gl_LocalInvocationID.x == 0)
+    {
+        cdf[0] = 0.0;
+        total = covered;
+    }
+}
+#endif
+)";
+
+static_assert(IndexHistogram::Bins % IndexHistogram::ScanGroupSize == 0, "The scan splits the bins evenly");
+
+std::string IndexHistogram::GetSource()
+{
+	return std::format("#define HISTOGRAM_BINDING {}\n#define BINS {}u\n", Binding, Bins) + s_CommonSrc;
+}
+
+static GLuint CreatePass(const char* pass)
+{
+	std::string source = std::format("#version 430 core\n#define {}\n#define SCAN_GROUP_SIZE {}\n", pass, IndexHistogram::ScanGroupSize);
+	return CreateComputeShader(source + IndexHistogram::GetSource() + s_BuildSrc);
+}
+
+IndexHistogram::IndexHistogram()
+{
+	m_RangeProgram = CreatePass("RANGE");
+	m_CountProgram = CreatePass("COUNT");
+	m_ScanProgram = CreatePass("SCAN");
+
+	// Range keys, total and padding, then the counts and the cdf
+	glGenBuffers(1, &m_Buffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_Buffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, 4 * sizeof(uint32_t) + Bins * sizeof(uint32_t) + (Bins + 1) * sizeof(float), nullptr, GL_DYNAMIC_COPY);
+}
+
+IndexHistogram::~IndexHistogram()
+{
+	glDeleteProgram(m_RangeProgram);
+	glDeleteProgram(m_CountProgram);
+	glDeleteProgram(m_ScanProgram);
+
+	glDeleteBuffers(1, &m_Buffer);
+}
+
+void IndexHistogram::Bind() const
+{
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, Binding, m_Buffer);
+}
+
+void IndexHistogram::Build(GLuint samples, const glm::uvec2& size, uint32_t stride)
+{
+	// Empty range and no counts
+	const uint32_t header[4] = { 0xFFFFFFFF, 0, 0, 0 };
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_Buffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(header), header);
+	glClearBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, sizeof(header), Bins * sizeof(uint32_t), GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, Binding, m_Buffer);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, samples);
+
+	const glm::uvec2 pixels = (size + stride - 1u) / stride;
+	const glm::uvec2 groups = (pixels + 15u) / 16u;
+
+	for (GLuint program : { m_RangeProgram, m_CountProgram })
+	{
+		glProgramUniform2ui(program, 0, size.x, size.y);
+		glProgramUniform1ui(program, 1, stride);
+	}
+
+	glUseProgram(m_RangeProgram);
+	glDispatchCompute(groups.x, groups.y, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+	glUseProgram(m_CountProgram);
+	glDispatchCompute(groups.x, groups.y, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+	glUseProgram(m_ScanProgram);
+	glDispatchCompute(1, 1, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <GLCore.h>
+
+// Histogram of the color index of the covered pixels, built on the GPU from the
+// samples of the fractal shaders. Its cumulative distribution spreads the
+// indices of any view evenly, so the colors do not need to be tuned again for
+// every location. Nothing is read back, the shaders that include GetSource
+// read it straight from the buffer.
+class IndexHistogram
+{
+public:
+	IndexHistogram();
+	~IndexHistogram();
+
+	// Rebuilds the histogram from the samples of every `stride`-th pixel, the
+	// ones shown by ColorResolve. Leaves it bound to `Binding`.
+	void Build(GLuint samples, const glm::uvec2& size, uint32_t stride);
+
+	// Binds the last build to `Binding`, to color with it again
+	void Bind() const;
+
+	// Declares the histogram and `float equalize(float index)`, the fraction of
+	// the covered pixels with a lower index. Needs GLSL 4.30.
+	static std::string GetSource();
+
+	static constexpr GLuint Binding = 4;
+
+	// Spread logarithmically over the range of the indices of the last build
+	static constexpr uint32_t Bins = 1024;
+
+	// Work group size of the scan over the bins
+	static constexpr uint32_t ScanGroupSize = 256;
+
+private:
+	GLuint m_RangeProgram = 0;
+	GLuint m_CountProgram = 0;
+	GLuint m_ScanProgram = 0;
+
+	GLuint m_Buffer = 0;
+};
@@ -290,8 +290,9 @@ glm::dvec2 ZoomToScreenPos(const glm::uvec2& resolution, double initial_radius,
 
 void ZoomToScreenPos(FractalVisualizer& fract, ImVec2 pos, double radius)
 {
-	auto new_center = ZoomToScreenPos(fract.GetSize(), fract.GetRadius(), fract.GetCenter(), pos, radius);
-	fract.SetCenter(new_center);
+	// Offsets keep working past the double precision limit
+	glm::dvec2 offset = fract.MapCoordsToOffset(pos);
+	fract.MoveCenter(offset * (1.0 - radius / fract.GetRadius()));
 	fract.SetRadius(radius);
 }
 
@@ -307,14 +308,11 @@ void FractalHandleInteract(FractalVisualizer& fract, int resolutionPercentage)
 		if (ImGui::IsMouseDragging(ImGuiMouseButton_Left, 0) && mousePos.y >= 0)
 		{
 			if (mouseDeltaScaled.x != 0 || mouseDeltaScaled.y != 0)
-			{
-				glm::dvec2 center = fract.MapCoordsToPos(fract.MapPosToCoords(fract.GetCenter()) - mouseDeltaScaled);
-				fract.SetCenter(center);
-			}
+				fract.Pan(mouseDeltaScaled);
 		}
 
 		if (ImGui::IsMouseClicked(ImGuiMouseButton_Left) && io.KeyCtrl)
-			fract.SetCenter(fract.MapCoordsToPos(mousePos));
+			fract.MoveCenter(fract.MapCoordsToOffset(mousePos));
 	}
 }
 
@@ -390,7 +388,7 @@ void PositionPicker(const char* label, double center[2], double* radius, const F
 		ImGui::PushItemWidth(ImGui::CalcItemWidth() - ImGui::GetContentRegionAvail().x);
 		ImGui::DragScalarN("Center", ImGuiDataType_Double, center, 2, 0.01f, nullptr, nullptr, "%.15f");
 
-		double rmin = 1e-15, rmax = 50;
+		double rmin = fract.GetMinRadius(), rmax = 50;
 		ImGui::DragScalar("Radius", ImGuiDataType_Double, radius, 0.01f, &rmin, &rmax, "%e", ImGuiSliderFlags_Logarithmic);
 
 		ImGui::PopItemWidth();
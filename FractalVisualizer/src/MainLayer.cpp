@@ -7,8 +7,10 @@
 #include <algorithm>
 #include <functional>
 #include <ranges>
+#include <numeric>
 
 #include "LayerUtils.h"
+#include "RenderTasks.h"
 #include <imgui_internal.h>
 #include <IconsMaterialDesign.h>
 
@@ -48,10 +50,13 @@ MainLayer::MainLayer()
 	m_Mandelbrot.SetEqExponent(m_EqExponent);
 	m_Julia.SetEqExponent(m_EqExponent);
 
+	m_Julia.SetJuliaC(m_JuliaC);
+
 	m_Mandelbrot.SetCenter({ -0.5, 0 });
 	m_Julia.SetRadius(1.3);
 
 	m_VideoRenderer.SetColorFunction(GetColorFunction(m_SelectedColor));
+	m_RenderColorPending = true;
 	m_VideoRenderer.Prepare(m_MandelbrotSrcPath, m_Mandelbrot);
 
 	m_MandelbrotZoomData.start_radius = m_Mandelbrot.GetRadius();
@@ -65,8 +70,11 @@ MainLayer::MainLayer()
 
 MainLayer::~MainLayer()
 {
-	for (auto prev : m_ColorsPreview)
+	m_ColorLoader.Cancel();
+
+	for (auto& prev : m_ColorsPreview)
 	{
+		CancelProgram(prev.pending);
 		glDeleteTextures(1, &prev.textureID);
 		glDeleteProgram(prev.shaderID);
 	}
@@ -74,7 +82,7 @@ MainLayer::~MainLayer()
 
 std::shared_ptr<ColorFunction> MainLayer::GetColorFunction(size_t index) const
 {
-	if (m_ColorsError[index])
+	if (m_ColorsPreview[index].state != ColorState::Done || m_ColorsError[index])
 		return ColorFunction::Default;
 	else
 		return m_Colors[index];
@@ -115,6 +123,12 @@ void MainLayer::OnAttach()
 	io.Fonts->AddFontFromFileTTF("assets/fonts/MaterialIcons-Regular.ttf", 13.0f, &config, icon_ranges);
 }
 
+// Part of the target frame time the fractals can take
+static const double FRACTAL_FRAME_SHARE = 0.75;
+
+// Most of that the queued renders take from the views in sight
+static const double MAX_JOB_SHARE = 0.75;
+
 void MainLayer::OnUpdate(GLCore::Timestep ts)
 {
 	m_FrameRate = 1 / ts.GetSeconds();
@@ -124,15 +138,29 @@ void MainLayer::OnUpdate(GLCore::Timestep ts)
 		RefreshColorFunctions();
 		m_ShouldRefreshColors = false;
 	}
+	PollColorFunctions();
 
-	switch (m_State)
-	{
-	case State::Exploring:
+	// Queued renders get their part of the frame, the views split the rest
+	const int visible = !m_MandelbrotMinimized + !m_JuliaMinimized;
+	const double fractalTime = m_TargetFrameTime * FRACTAL_FRAME_SHARE;
+	double jobTime = 0.0;
+	if (m_RenderQueue.IsBusy())
+		jobTime = visible > 0 ? std::min((double)m_JobFrameTime, fractalTime * MAX_JOB_SHARE) : std::max((double)m_JobFrameTime, fractalTime);
+
+	// The CPU backend steps in the background, it does not hold the frame
+	if (m_AutoBudget && m_Backend != (int)Backend::Cpu)
 	{
-		glUseProgram(m_Julia.GetShader());
-		GLint loc = glGetUniformLocation(m_Julia.GetShader(), "i_JuliaC");
-		glUniform2d(loc, m_JuliaC.x, m_JuliaC.y);
+		// Split between the visible fractals, the rest is left for the UI
+		const double budget = (fractalTime - jobTime) / std::max(visible, 1);
 
+		if (!m_MandelbrotMinimized)
+			m_MandelbrotBudget.Run(m_Mandelbrot, budget);
+
+		if (!m_JuliaMinimized)
+			m_JuliaBudget.Run(m_Julia, budget);
+	}
+	else
+	{
 		for (int i = 0; i < m_StepsPerFrame; i++)
 		{
 			if (!m_MandelbrotMinimized)
@@ -141,45 +169,17 @@ void MainLayer::OnUpdate(GLCore::Timestep ts)
 			if (!m_JuliaMinimized)
 				m_Julia.Update();
 		}
-
-		if (m_ShouldUpdatePreview && !m_PreviewMinimized)
-		{
-			m_VideoRenderer.UpdateToFractal();
-			m_VideoRenderer.UpdateIter(m_PreviewT);
-			m_ShouldUpdatePreview = false;
-		}
-		break;
 	}
-	case State::Rendering:
-	{
-		auto& data = m_VideoRenderer;
-		auto& i = data.current_iter;
-
-		if (i < data.steps)
-		{
-			data.UpdateIter(i / (float)(data.steps - 1));
-
-			glBindTexture(GL_TEXTURE_2D, data.fract->GetTexture());
-			glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, data.pixels);
-
-			fwrite(data.pixels, data.resolution.x * data.resolution.y * 4 * sizeof(BYTE), 1, data.ffmpeg);
-
-			i++;
-		}
-		else // finished
-		{
-			m_State = State::Exploring;
-
-			_pclose(data.ffmpeg);
-			delete[] data.pixels;
-		}
 
-		break;
-	}
-	default:
-		break;
+	if (m_ShouldUpdatePreview && !m_PreviewMinimized)
+	{
+		m_VideoRenderer.UpdateToFractal();
+		m_VideoRenderer.UpdateIter(m_PreviewT);
+		m_ShouldUpdatePreview = false;
 	}
 
+	m_RenderQueue.Run(jobTime);
+
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
 	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
@@ -223,7 +223,7 @@ void MainLayer::UpdatePlots()
 	{
 		double t = n / (double)(N_SAMPLES - 1);
 
-		glm::dvec2 center = m_VideoRenderer.GetCenter(t, 1e-1);
+		glm::dvec2 center = m_VideoRenderer.GetCenter(t);
 		centerPoints[n] = ImPlotPoint(center.x, center.y);
 #ifdef GLCORE_DEBUG
 		centerXPoints[n] = ImPlotPoint(t, center.x);
@@ -234,12 +234,6 @@ void MainLayer::UpdatePlots()
 	}
 }
 
-template<typename T>
-void SortKeyFrames(KeyFrameList<T>& keyFrames)
-{
-	std::ranges::sort(keyFrames, [](auto a, auto b) { return a->t < b->t; });
-}
-
 void MainLayer::OnImGuiRender()
 {
 	ImGui::DockSpaceOverViewport();
@@ -253,32 +247,41 @@ void MainLayer::OnImGuiRender()
 			ImPlot::PlotLine("x", &centerXPoints[0].x, &centerXPoints[0].y, N_SAMPLES, 0, 0, sizeof(ImPlotPoint));
 			ImPlot::PlotLine("y", &centerYPoints[0].x, &centerYPoints[0].y, N_SAMPLES, 0, 0, sizeof(ImPlotPoint));
 
-			for (auto p : m_VideoRenderer.centerKeyFrames)
+			auto& center = m_VideoRenderer.centerKeyFrames;
+			int moved = -1;
+			double moved_t = 0.0;
+			for (int i = 0; i < (int)center.Size(); i++)
 			{
-				ImGui::PushID(p.get());
+				ImGui::PushID((int)center.GetId(i));
 
-				if (ImPlot::DragPoint(0, &p->val.pos.x, &p->val.pos.y, ImVec4(0.8f, 0.8f, 0.8f, 1.f)))
-					UpdatePlots();
+				CenterKey key = center.GetValue(i);
+				double t = center.GetTime(i);
 
-				if (ImPlot::DragPoint(1, &p->t, &p->val.pos.x, ImVec4(0.8f, 0.8f, 0.8f, 1.f), 4.f, ImPlotDragToolFlags_Delayed))
+				if (ImPlot::DragPoint(0, &key.pos.x, &key.pos.y, ImVec4(0.8f, 0.8f, 0.8f, 1.f)))
 				{
-					if (p->t < 0.0) p->t = 0.0;
-					if (p->t > 1.0) p->t = 1.0;
+					center.SetValue(i, key);
 					UpdatePlots();
-					SortKeyFrames(m_VideoRenderer.centerKeyFrames);
 				}
 
-				if (ImPlot::DragPoint(2, &p->t, &p->val.pos.y, ImVec4(0.8f, 0.8f, 0.8f, 1.f), 4.f, ImPlotDragToolFlags_Delayed))
+				bool dragged = ImPlot::DragPoint(1, &t, &key.pos.x, ImVec4(0.8f, 0.8f, 0.8f, 1.f), 4.f, ImPlotDragToolFlags_Delayed);
+				dragged |= ImPlot::DragPoint(2, &t, &key.pos.y, ImVec4(0.8f, 0.8f, 0.8f, 1.f), 4.f, ImPlotDragToolFlags_Delayed);
+				if (dragged)
 				{
-					if (p->t < 0.0) p->t = 0.0;
-					if (p->t > 1.0) p->t = 1.0;
-					UpdatePlots();
-					SortKeyFrames(m_VideoRenderer.centerKeyFrames);
+					center.SetValue(i, key);
+					moved = i;
+					moved_t = std::clamp(t, 0.0, 1.0);
 				}
 
 				ImGui::PopID();
 			}
 
+			// Moving it now would reorder the points being drawn
+			if (moved >= 0)
+			{
+				center.SetTime(moved, moved_t);
+				UpdatePlots();
+			}
+
 			ImPlot::EndPlot();
 		}
 		if (ImPlot::BeginPlot("##Radius", ImVec2(-1, 700)))
@@ -286,19 +289,30 @@ void MainLayer::OnImGuiRender()
 			ImPlot::SetupAxisScale(ImAxis_Y1, ImPlotScale_Log10);
 			ImPlot::PlotLine("Radius", &radiusPoints[0].x, &radiusPoints[0].y, N_SAMPLES, 0, 0, sizeof(ImPlotPoint));
 
-			for (auto [i, p] : std::views::enumerate(m_VideoRenderer.radiusKeyFrames))
+			auto& radius = m_VideoRenderer.radiusKeyFrames;
+			int moved = -1;
+			double moved_t = 0.0;
+			for (int i = 0; i < (int)radius.Size(); i++)
 			{
-				ImGui::PushID(p.get());
-				if (ImPlot::DragPoint(0, &p->t, &p->val, ImVec4(0.8f, 0.8f, 0.8f, 1.f), 4.f, ImPlotDragToolFlags_Delayed))
+				ImGui::PushID((int)radius.GetId(i));
+
+				double t = radius.GetTime(i);
+				double r = radius.GetValue(i);
+				if (ImPlot::DragPoint(0, &t, &r, ImVec4(0.8f, 0.8f, 0.8f, 1.f), 4.f, ImPlotDragToolFlags_Delayed))
 				{
-					if (p->t < 0.0) p->t = 0.0;
-					if (p->t > 1.0) p->t = 1.0;
-					UpdatePlots();
-					SortKeyFrames(m_VideoRenderer.radiusKeyFrames);
+					radius.SetValue(i, r);
+					moved = i;
+					moved_t = std::clamp(t, 0.0, 1.0);
 				}
 				ImGui::PopID();
 			}
 
+			if (moved >= 0)
+			{
+				radius.SetTime(moved, moved_t);
+				UpdatePlots();
+			}
+
 			ImPlot::EndPlot();
 		}
 	}
@@ -347,6 +361,8 @@ void MainLayer::OnImGuiRender()
 	ShowMandelbrotWindow();
 }
 
+static const double ZOOM_SETTLE_TIME = 0.25;
+
 void FractalHandleZoom(FractalVisualizer& fract, int resolutionPercentage, float fps, bool smoothZoom, SmoothZoomData& data)
 {
 	auto& io = ImGui::GetIO();
@@ -358,8 +374,12 @@ void FractalHandleZoom(FractalVisualizer& fract, int resolutionPercentage, float
 		data.target_pos = WindowPosToImagePos(ImGui::GetMousePos(), resolutionPercentage);
 		data.t = 0.0;
 
+		data.wheel_time = ImGui::GetTime();
+
 		if (!smoothZoom)
 			data.t = 1.0;
+
+		fract.SetPreview(true);
 		ZoomToScreenPos(fract, data.target_pos, data.target_radius);
 	}
 	if (smoothZoom)
@@ -379,6 +399,9 @@ void FractalHandleZoom(FractalVisualizer& fract, int resolutionPercentage, float
 			ZoomToScreenPos(fract, data.target_pos, radius);
 		}
 	}
+
+	// The full render only starts once the zoom settles
+	fract.SetPreview(data.t < 1.0 || ImGui::GetTime() - data.wheel_time < ZOOM_SETTLE_TIME);
 }
 
 static const float DRAG_GRAB_HALF_SIZE = 4.0f;
@@ -457,28 +480,38 @@ bool MainLayer::ShowCenterKeyFrames(const FractalVisualizer& fract)
 
 	bool val_changed = false;
 
-	for (auto p : m_VideoRenderer.centerKeyFrames)
+	auto& center = m_VideoRenderer.centerKeyFrames;
+	for (size_t i = 0; i < center.Size(); i++)
 	{
-		ImGui::PushID(p.get());
+		ImGui::PushID((int)center.GetId(i));
+
+		CenterKey key = center.GetValue(i);
+		bool changed = false;
 
 		bool hover = false;
-		if (DragPoint(0, &(p->val.pos), fract, m_ResolutionPercentage, ImVec4(1, 1, 1, 1), 5, 0, nullptr, &hover))
-			val_changed = true;
+		if (DragPoint(0, &key.pos, fract, m_ResolutionPercentage, ImVec4(1, 1, 1, 1), 5, 0, nullptr, &hover))
+			changed = true;
 		
 		if (hover && ImGui::IsMouseDoubleClicked(0))
 		{
-			if (p->val.vel == glm::dvec2(0))
-				p->val.vel = glm::dvec2(0.0, fract.GetRadius());
+			if (key.vel == glm::dvec2(0))
+				key.vel = glm::dvec2(0.0, fract.GetRadius());
 			else
-				p->val.vel = glm::dvec2(0);
+				key.vel = glm::dvec2(0);
 
-			val_changed = true;
+			changed = true;
 		}
 
-		auto handle = p->val.pos + 0.1*p->val.vel;
+		auto handle = key.pos + 0.1*key.vel;
 		if (DragPoint(1, &handle, fract, m_ResolutionPercentage, ImVec4(0.8f, 0.8f, 0.8f, 0.9f), 4))
 		{
-			p->val.vel = (handle - p->val.pos) / 0.1;
+			key.vel = (handle - key.pos) / 0.1;
+			changed = true;
+		}
+
+		if (changed)
+		{
+			center.SetValue(i, key);
 			val_changed = true;
 		}
 
@@ -516,7 +549,7 @@ void MainLayer::ShowMandelbrotWindow()
 				(ImGui::IsMouseDragging(ImGuiMouseButton_Right, 0) && (io.MouseDelta.x != 0 || io.MouseDelta.y != 0)))
 			{
 				m_JuliaC = WindowToFract(ImGui::GetMousePos(), m_Mandelbrot, m_ResolutionPercentage);
-				m_Julia.ResetRender();
+				m_Julia.SetJuliaC(m_JuliaC);
 			}
 		}
 
@@ -593,17 +626,39 @@ void MainLayer::ShowControlsWindow()
 
 		if (ImGui::CollapsingHeader("General"))
 		{
-			if (ImGui::DragInt("Iterations per step", &m_ItersPerSteps, 10, 1, 10000, "%d", ImGuiSliderFlags_AlwaysClamp))
+			if (ImGui::Checkbox("Auto budget", &m_AutoBudget) && !m_AutoBudget)
 			{
 				m_Mandelbrot.SetIterationsPerFrame(m_ItersPerSteps);
 				m_Julia.SetIterationsPerFrame(m_ItersPerSteps);
 			}
 
-			if (ImGui::DragInt("Steps per frame", &m_StepsPerFrame, 1, 1, 100, "%d", ImGuiSliderFlags_AlwaysClamp))
+			ImGui::SameLine(); HelpMarker("Picks the iterations per step and the steps per frame of each fractal so that they take the target frame time on the GPU. Not used by the CPU backend.");
+
+			if (m_AutoBudget)
+			{
+				ImGui::DragFloat("Target frame time", &m_TargetFrameTime, 0.1f, 1.f, 100.f, "%.1f ms", ImGuiSliderFlags_AlwaysClamp);
+
+				if (!m_MandelbrotMinimized)
+					ImGui::Text("Mandelbrot: %d x %d iterations, %.1f ms", m_MandelbrotBudget.GetSteps(), m_MandelbrotBudget.GetIterations(), m_MandelbrotBudget.GetTime());
+				if (!m_JuliaMinimized)
+					ImGui::Text("Julia: %d x %d iterations, %.1f ms", m_JuliaBudget.GetSteps(), m_JuliaBudget.GetIterations(), m_JuliaBudget.GetTime());
+			}
+
+			ImGui::BeginDisabled(m_AutoBudget && m_Backend != (int)Backend::Cpu);
 			{
-				m_Mandelbrot.ResetRender();
-				m_Julia.ResetRender();
+				if (ImGui::DragInt("Iterations per step", &m_ItersPerSteps, 10, 1, 10000, "%d", ImGuiSliderFlags_AlwaysClamp))
+				{
+					m_Mandelbrot.SetIterationsPerFrame(m_ItersPerSteps);
+					m_Julia.SetIterationsPerFrame(m_ItersPerSteps);
+				}
+
+				if (ImGui::DragInt("Steps per frame", &m_StepsPerFrame, 1, 1, 100, "%d", ImGuiSliderFlags_AlwaysClamp))
+				{
+					m_Mandelbrot.ResetRender();
+					m_Julia.ResetRender();
+				}
 			}
+			ImGui::EndDisabled();
 
 			if (ImGui::DragInt("Resolution percentage", &m_ResolutionPercentage, 1, 30, 500, "%d%%", ImGuiSliderFlags_AlwaysClamp))
 			{
@@ -614,12 +669,51 @@ void MainLayer::ShowControlsWindow()
 				m_Julia.SetSize(juliaSize);
 			}
 
+			if (ImGui::Checkbox("Dynamic resolution", &m_DynamicResolution))
+			{
+				m_Mandelbrot.SetDynamicResolution(m_DynamicResolution);
+				m_Julia.SetDynamicResolution(m_DynamicResolution);
+			}
+
 			if (ImGui::DragInt("Equation exponent", &m_EqExponent, 0.1f, 2, INT_MAX, "%d", ImGuiSliderFlags_AlwaysClamp))
 			{
 				m_Mandelbrot.SetEqExponent(m_EqExponent);
 				m_Julia.SetEqExponent(m_EqExponent);
 			}
 
+			if (ImGui::Combo("Backend", &m_Backend, "Fragment\0Compute\0CPU\0"))
+			{
+				m_Mandelbrot.SetBackend((Backend)m_Backend);
+				m_Julia.SetBackend((Backend)m_Backend);
+
+				// The budget is not used by the CPU backend
+				m_Mandelbrot.SetIterationsPerFrame(m_ItersPerSteps);
+				m_Julia.SetIterationsPerFrame(m_ItersPerSteps);
+			}
+
+			if (m_Backend == (int)Backend::Compute)
+			{
+				if (ImGui::DragInt("Work group size", &m_WorkGroupSize, 1.0f, 1, 1024, "%d", ImGuiSliderFlags_AlwaysClamp))
+				{
+					m_Mandelbrot.SetWorkGroupSize(m_WorkGroupSize);
+					m_Julia.SetWorkGroupSize(m_WorkGroupSize);
+				}
+
+				if (ImGui::Combo("Render mode", &m_RenderMode, "Full\0Guessing\0"))
+				{
+					m_Mandelbrot.SetRenderMode((RenderMode)m_RenderMode);
+					m_Julia.SetRenderMode((RenderMode)m_RenderMode);
+				}
+
+				if (m_RenderMode == (int)RenderMode::Guessing && !m_Mandelbrot.GetPerturbation() && m_Mandelbrot.IsGuessingDone())
+				{
+					MarianiSilver::Stats stats = m_Mandelbrot.GetGuessStats();
+					ImGui::Text("Guessed %u, computed %u pixels", stats.guessed, stats.computed);
+				}
+			}
+			else if (m_Backend == (int)Backend::Cpu)
+				ImGui::Text("Kernel: %s", GetCpuKernelName());
+
 			if (ImGui::ColorEdit3("Set Color", glm::value_ptr(m_SetColor))) 
 			{
 				m_Mandelbrot.SetSetColor(m_SetColor);
@@ -716,6 +810,13 @@ void MainLayer::ShowControlsWindow()
 				m_Julia.SetSmoothColor(m_SmoothColor);
 			}
 
+			if (ImGui::Checkbox("Equalize", &m_Equalize))
+			{
+				m_Mandelbrot.SetEqualize(m_Equalize);
+				m_Julia.SetEqualize(m_Equalize);
+			}
+			ImGui::SameLine(); HelpMarker("Spreads the colors evenly over the iterations in view, the scale of the color function sets how many times they repeat.");
+
 			if (ImGui::Button("Refresh"))
 				m_ShouldRefreshColors = true;
 
@@ -764,6 +865,10 @@ void MainLayer::ShowControlsWindow()
 				ImGui::Text("Errors:");
 				ImGui::TextColored(ImColor(255, 50, 50), m_ColorsError[m_SelectedColor].value().c_str());
 			}
+			else if (m_ColorsPreview[m_SelectedColor].state != ColorState::Done)
+			{
+				ImGui::TextDisabled("Loading...");
+			}
 			else
 			{
 				ImGui::Text("Color function parameters");
@@ -794,41 +899,12 @@ void MainLayer::ShowControlsWindow()
 						break;
 					}
 					}
-					if (modified)
-					{
-						m_Mandelbrot.ResetRender();
-						m_Julia.ResetRender();
-
-						if (uniform->update)
-						{
-							updated = true;
-							uniform->UpdateToShader(m_ColorsPreview[m_SelectedColor].shaderID);
-						}
-					}
+					if (modified && uniform->update)
+						updated = true;
 				}
 
 				if (updated)
-				{
-					GLuint fb;
-					glGenFramebuffers(1, &fb);
-					glBindFramebuffer(GL_FRAMEBUFFER, fb);
-
-					glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_ColorsPreview[m_SelectedColor].textureID, 0);
-					GLenum buffers[] = { GL_COLOR_ATTACHMENT0 };
-					glDrawBuffers(1, buffers);
-
-					glUseProgram(m_ColorsPreview[m_SelectedColor].shaderID);
-
-					glViewport(0, 0, previewSize.x, previewSize.y);
-					glDisable(GL_BLEND);
-
-					glBindVertexArray(GLCore::Application::GetDefaultQuadVA());
-					glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
-
-					glDeleteFramebuffers(1, &fb);
-
-					glBindFramebuffer(GL_FRAMEBUFFER, 0);
-				}
+					DrawColorPreview(m_SelectedColor);
 			}
 			ImGui::Spacing();
 		}
@@ -845,9 +921,20 @@ void MainLayer::ShowControlsWindow()
 			if (ImGui::DragScalarN("Center", ImGuiDataType_Double, glm::value_ptr(center), 2, (float)m_Mandelbrot.GetRadius() / 70.f, &cmin, &cmax, "%.15f"))
 				m_Mandelbrot.SetCenter(center);
 
+			bool perturbation = m_Mandelbrot.GetPerturbation();
+			if (ImGui::Checkbox("Perturbation (deep zoom)", &perturbation))
+				m_Mandelbrot.SetPerturbation(perturbation);
+
+			if (!perturbation)
+			{
+				int precision = (int)m_Mandelbrot.GetPrecision();
+				if (ImGui::Combo("Precision", &precision, "Double\0Float-float\0Double-double\0"))
+					m_Mandelbrot.SetPrecision((Precision)precision);
+			}
+
 			//double rmin = 1e-15, rmax = 50;
 			double radius = m_Mandelbrot.GetRadius();
-			if (DragDouble("Radius", &radius, 0.01f, 1e-15, 50, "%e", ImGuiSliderFlags_Logarithmic))
+			if (DragDouble("Radius", &radius, 0.01f, m_Mandelbrot.GetMinRadius(), 50, "%e", ImGuiSliderFlags_Logarithmic))
 			//if (ImGui::DragScalar("Radius", ImGuiDataType_Double, &radius, 0.01f, &rmin, &rmax, "%e", ImGuiSliderFlags_Logarithmic))
 			{
 				m_Mandelbrot.SetRadius(radius);
@@ -879,9 +966,20 @@ void MainLayer::ShowControlsWindow()
 			if (ImGui::DragScalarN("Center", ImGuiDataType_Double, glm::value_ptr(center), 2, (float)m_Julia.GetRadius() / 200.f, &cmin, &cmax, "%.15f"))
 				m_Julia.SetCenter(center);
 
+			bool perturbation = m_Julia.GetPerturbation();
+			if (ImGui::Checkbox("Perturbation (deep zoom)", &perturbation))
+				m_Julia.SetPerturbation(perturbation);
+
+			if (!perturbation)
+			{
+				int precision = (int)m_Julia.GetPrecision();
+				if (ImGui::Combo("Precision", &precision, "Double\0Float-float\0Double-double\0"))
+					m_Julia.SetPrecision((Precision)precision);
+			}
+
 			//double rmin = 1e-15, rmax = 50;
 			double radius = m_Julia.GetRadius();
-			if (DragDouble("Radius", &radius, 0.01f, 1e-15, 50, "%e", ImGuiSliderFlags_Logarithmic))
+			if (DragDouble("Radius", &radius, 0.01f, m_Julia.GetMinRadius(), 50, "%e", ImGuiSliderFlags_Logarithmic))
 			//if (ImGui::DragScalar("Radius", ImGuiDataType_Double, &radius, 0.01f, &rmin, &rmax, "%e", ImGuiSliderFlags_Logarithmic))
 			{
 				m_Julia.SetRadius(radius);
@@ -890,7 +988,7 @@ void MainLayer::ShowControlsWindow()
 			}
 
 			if (ImGui::DragScalarN("C value", ImGuiDataType_Double, glm::value_ptr(m_JuliaC), 2, (float)m_Julia.GetRadius() * 1e-5f, &cmin, &cmax, "%.15f"))
-				m_Julia.ResetRender();
+				m_Julia.SetJuliaC(m_JuliaC);
 
 
 			if (ImGui::Button("Screenshot"))
@@ -911,25 +1009,26 @@ void MainLayer::ShowControlsWindow()
 }
 
 template<typename T>
-bool EditKeyFrames(KeyFrameList<T>& keyFrames, T new_val, double new_t, std::function<bool(T&)> value_edit)
+bool EditKeyFrames(AnimationTrack<T>& keyFrames, T new_val, double new_t, std::function<bool(T&)> value_edit)
 {
 	bool val_changed = false;
-	bool edited_time = false;
 
 	ImGui::SameLine();
 	if (ImGui::SmallButton("+"))
 	{
-		keyFrames.emplace_back(std::make_shared<KeyFrame<T>>(new_t, new_val));
-		edited_time = true;
+		keyFrames.Insert(new_t, new_val);
 		val_changed = true;
 	}
 
 	int deleted_index = -1;
-	for (int i = 0; i < keyFrames.size(); i++)
+	int moved_index = -1;
+	double moved_t = 0.0;
+	for (int i = 0; i < (int)keyFrames.Size(); i++)
 	{
-		auto& [t, v] = *(keyFrames[i]);
+		double t = keyFrames.GetTime(i);
+		T v = keyFrames.GetValue(i);
 
-		ImGui::PushID(keyFrames[i].get());
+		ImGui::PushID((int)keyFrames.GetId(i));
 
 		if (CloseButton("##close"))
 			deleted_index = i;
@@ -940,7 +1039,8 @@ bool EditKeyFrames(KeyFrameList<T>& keyFrames, T new_val, double new_t, std::fun
 
 		if (DragDouble("##time", &t, 0.01f, 0.f, 1.f, "%.3f", ImGuiSliderFlags_AlwaysClamp))
 		{
-			edited_time = true;
+			moved_index = i;
+			moved_t = t;
 			val_changed = true;
 		}
 
@@ -949,21 +1049,23 @@ bool EditKeyFrames(KeyFrameList<T>& keyFrames, T new_val, double new_t, std::fun
 		ImGui::PushItemWidth(ImGui::CalcItemWidth() * 0.75f);
 
 		if (value_edit(v))
+		{
+			keyFrames.SetValue(i, v);
 			val_changed = true;
+		}
 
 		ImGui::PopItemWidth();
 
 		ImGui::PopID();
 	}
-	if (edited_time)
-		SortKeyFrames(keyFrames);
-
-	if (deleted_index >= 0)
-		if (keyFrames.size() > 1)
-		{
-			keyFrames.erase(keyFrames.begin() + deleted_index);
-			val_changed = true;
-		}
+	if (deleted_index >= 0 && keyFrames.Size() > 1)
+	{
+		keyFrames.Erase(deleted_index);
+		val_changed = true;
+	}
+	// Moving it now would reorder the rows being drawn
+	else if (moved_index >= 0)
+		keyFrames.SetTime(moved_index, moved_t);
 
 	return val_changed;
 }
@@ -1001,19 +1103,16 @@ void MainLayer::ShowRenderWindow()
 				std::string fileName = std::format("{}_{:.15f},{:.15f}", fractal_names[fractal_index], display_pos.x, display_pos.y);
 				if (SaveImageDialog(fileName))
 				{
-					fract.SetCenter(center);
-					fract.SetRadius(radius);
-					fract.SetSize(resolution);
-					fract.SetIterationsPerFrame(iters_per_step);
-
-					fract.ResetRender();
+					ImageRenderTask::View view;
+					view.center = center;
+					view.radius = radius;
+					view.resolution = resolution;
+					view.steps = steps;
+					view.iterations = iters_per_step;
 
-					for (int i = 0; i < steps; i++)
-						fract.Update();
-
-					GLCore::Utils::ExportTexture(fract.GetTexture(), fileName, true);
-
-					glBindFramebuffer(GL_FRAMEBUFFER, 0);
+					const auto& path = fractal_index == 0 ? m_MandelbrotSrcPath : m_JuliaSrcPath;
+					const std::string name = std::filesystem::path(fileName).filename().string();
+					m_RenderQueue.Push(name, m_JobPriority, std::make_unique<ImageRenderTask>(path, fract, view, fileName));
 				}
 			}
 
@@ -1028,17 +1127,6 @@ void MainLayer::ShowRenderWindow()
 
 			auto& data = m_VideoRenderer;
 
-			//bool rendering_video = m_State == State::Rendering;
-			if (ImGui::BeginPopupModal("Rendering Video", nullptr, ImGuiWindowFlags_AlwaysAutoResize))
-			{
-				ImGui::ProgressBar(data.current_iter / (float)data.steps, { 200, 0 });
-
-				if (m_State != State::Rendering)
-					ImGui::CloseCurrentPopup();
-
-				ImGui::EndPopup();
-			}
-
 			const char* fractal_names[] = { "Mandelbrot", "Julia" };
 			static int fractal_index = 0;
 			if (ImGui::Combo("Fractal", &fractal_index, fractal_names, IM_ARRAYSIZE(fractal_names)))
@@ -1064,6 +1152,7 @@ void MainLayer::ShowRenderWindow()
 			if (ComboR("Color Function", &m_RenderColorIndex, (int)m_SelectedColor, m_ColorsName.data(), (int)m_ColorsName.size()))
 			{
 				data.SetColorFunction(GetColorFunction(m_RenderColorIndex));
+				m_RenderColorPending = m_ColorsPreview[m_RenderColorIndex].state != ColorState::Done;
 				m_ShouldUpdatePreview = true;
 			}
 
@@ -1167,52 +1256,100 @@ void MainLayer::ShowRenderWindow()
 
 			if (ImGui::Button("Render Video"))
 			{
-				data.fileName = std::format("{}_{:.15f},{:.15f}", fractal_names[fractal_index], data.centerKeyFrames.back()->val.pos.x, data.centerKeyFrames.back()->val.pos.y);
+				data.fileName = std::format("{}_{:.15f},{:.15f}", fractal_names[fractal_index], data.centerKeyFrames.GetValues().back().pos.x, data.centerKeyFrames.GetValues().back().pos.y);
 				if (GLCore::Application::Get().GetWindow().SaveFileDialog("mp4 (*.mp4)\0*.mp4\0", data.fileName))
 				{
-					m_State = State::Rendering;
-
 					const auto& path = fractal_index == 0 ? m_MandelbrotSrcPath : m_JuliaSrcPath;
 
-					data.Prepare(path, *fract);
-					double dt = data.duration / (double)data.steps;
+					const std::string name = std::filesystem::path(data.fileName).filename().string();
+					m_RenderQueue.Push(name, m_JobPriority, std::make_unique<VideoRenderTask>(data, path, *fract));
+				}
+			}
 
-					data.InvalidateRadius(dt * 1e-3);
-					data.InvalidateCenter();
+			ImGui::PopID();
+		}
 
-					auto width = data.resolution.x;
-					auto height = data.resolution.y;
+		ShowRenderQueue();
+	}
+	ImGui::End();
+}
 
-					std::stringstream cmd;
-					cmd << "ffmpeg ";
-					cmd << "-y ";
-					cmd << "-loglevel error ";
+static std::string FormatDuration(double seconds)
+{
+	const int total = (int)std::ceil(seconds);
+	if (total >= 3600)
+		return std::format("{}:{:02}:{:02}", total / 3600, total / 60 % 60, total % 60);
+	return std::format("{}:{:02}", total / 60, total % 60);
+}
 
-					cmd << "-r " << data.fps << " ";
-					cmd << "-f rawvideo ";
-					cmd << "-pix_fmt rgba ";
-					cmd << "-s " << width << "x" << height << " ";
-					cmd << "-i - ";
+void MainLayer::ShowRenderQueue()
+{
+	if (!ImGui::CollapsingHeader("Queue", ImGuiTreeNodeFlags_DefaultOpen))
+		return;
 
-					cmd << "-vcodec libx264 ";
-					cmd << "-pix_fmt yuv420p ";
-					cmd << "-crf 15 ";
-					cmd << "-vf \"vflip, pad = ceil(iw / 2) * 2:ceil(ih / 2) * 2\" ";
-					cmd << "\"" << data.fileName << "\"";
+	ImGui::PushID("Queue");
 
-					data.ffmpeg = _popen(cmd.str().c_str(), "wb");
-					data.pixels = new BYTE[width * height * 4];
+	ImGui::DragInt("Priority", &m_JobPriority, 0.1f, -10, 10, "%d", ImGuiSliderFlags_AlwaysClamp);
+	ImGui::SameLine(); HelpMarker("Of the renders added next. The one with the highest priority runs first, taking over from the others until it is done.");
 
-					//std::cout << "Please, do not close this window :)";
+	ImGui::DragFloat("Time per frame", &m_JobFrameTime, 0.1f, 1.f, 1000.f, "%.1f ms", ImGuiSliderFlags_AlwaysClamp);
+	ImGui::SameLine(); HelpMarker("Time the renders take every frame, as many steps as fit. While a fractal window is open they take at most part of the target frame time, otherwise at least all of it.");
 
-					ImGui::OpenPopup("Rendering Video");
-				}
-			}
+	ImGui::Spacing();
 
-			ImGui::PopID();
+	bool anyFinished = false;
+	for (const auto& job : m_RenderQueue.GetJobs())
+	{
+		ImGui::PushID((int)job.id);
+
+		ImGui::Text("%s", job.name.c_str());
+
+		std::string overlay;
+		switch (job.state)
+		{
+		case RenderQueue::JobState::Queued:    overlay = "Queued"; break;
+		case RenderQueue::JobState::Done:      overlay = std::format("Done in {}", FormatDuration(job.elapsed)); break;
+		case RenderQueue::JobState::Failed:    overlay = "Failed"; break;
+		case RenderQueue::JobState::Cancelled: overlay = "Cancelled"; break;
+		case RenderQueue::JobState::Running:
+			overlay = job.GetEta() < 0.0 ? std::format("{:.0f}%", job.progress * 100.f)
+				: std::format("{:.0f}%, {} left", job.progress * 100.f, FormatDuration(job.GetEta()));
+			break;
+		}
+
+		const float buttons = job.IsFinished() ? 0.f : 3.f * (ImGui::GetFrameHeight() + ImGui::GetStyle().ItemSpacing.x);
+		ImGui::ProgressBar(job.progress, { ImGui::GetContentRegionAvail().x - buttons, 0.f }, overlay.c_str());
+
+		if (job.IsFinished())
+			anyFinished = true;
+		else
+		{
+			ImGui::SameLine();
+			if (ImGui::Button(ICON_MD_ARROW_UPWARD))
+				m_RenderQueue.SetPriority(job.id, job.priority + 1);
+			if (ImGui::IsItemHovered())
+				ImGui::SetTooltip("Priority %d", job.priority);
+
+			ImGui::SameLine();
+			if (ImGui::Button(ICON_MD_ARROW_DOWNWARD))
+				m_RenderQueue.SetPriority(job.id, job.priority - 1);
+			if (ImGui::IsItemHovered())
+				ImGui::SetTooltip("Priority %d", job.priority);
+
+			ImGui::SameLine();
+			if (ImGui::Button(ICON_MD_CLOSE))
+				m_RenderQueue.Cancel(job.id);
+			if (ImGui::IsItemHovered())
+				ImGui::SetTooltip("Cancel");
 		}
+
+		ImGui::PopID();
 	}
-	ImGui::End();
+
+	if (anyFinished && ImGui::Button("Clear finished"))
+		m_RenderQueue.ClearFinished();
+
+	ImGui::PopID();
 }
 
 void MainLayer::ShowPreviewWindow()
@@ -1315,37 +1452,97 @@ void MainLayer::ShowHelpWindow()
 	ImGui::End();
 }
 
+// A single triangle over the viewport, drawn with no vertex data
+static const char* s_PreviewVertexSrc = R"(#version 400 core
+void main()
+{
+	vec2 p = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+	gl_Position = vec4(p * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+
+static std::string PreviewSource(const ColorFunction& colorFn)
+{
+	std::stringstream ss;
+	ss << "#version 400\n\n";
+	ss << colorFn.GetSource() << '\n';
+	ss << R"(
+layout (location = 0) out vec3 outColor;
+
+uniform uint i_Range;
+uniform uvec2 i_Size;
+
+void main()
+{
+	int i = int((gl_FragCoord.x / i_Size.x) * i_Range);
+	outColor = get_color(i);
+}
+	)";
+	return ss.str();
+}
+
 void MainLayer::RefreshColorFunctions()
 {
-	// Crear previews colors
-	m_Colors.clear();
+	// The previous refresh may still be parsing
+	m_ColorLoader.Cancel();
 
-	for (const auto& [prev, error] : std::views::zip(m_ColorsPreview, m_ColorsError))
+	// Crear previews colors
+	for (auto& prev : m_ColorsPreview)
 	{
-		if (!error)
-		{
-			glDeleteTextures(1, &prev.textureID);
-			glDeleteProgram(prev.shaderID);
-		}
+		CancelProgram(prev.pending);
+		glDeleteTextures(1, &prev.textureID);
+		glDeleteProgram(prev.shaderID);
 	}
 	m_ColorsPreview.clear();
+	m_Colors.clear();
 	m_ColorsError.clear();
 
+	std::vector<std::filesystem::path> paths;
+	for (const auto& entry : std::filesystem::directory_iterator("assets/colors"))
+		paths.push_back(entry.path());
+
+	// Shown until the preview is drawn
+	const std::vector<uint8_t> placeholder(previewSize.x * previewSize.y * 3, 64);
+
 	// Allocate new colors
-	m_Colors.reserve(10);
-	m_ColorsError.reserve(10);
-	for (const auto& path : std::filesystem::directory_iterator("assets/colors"))
+	m_Colors.reserve(paths.size());
+	m_ColorsError.reserve(paths.size());
+	m_ColorsPreview.reserve(paths.size());
+	for (const auto& path : paths)
 	{
-		std::ifstream colorSrc(path.path());
+		const auto& name = path.filename().replace_extension().string();
+		m_Colors.push_back(std::make_shared<ColorFunction>(name));
+		m_ColorsError.emplace_back();
 
-		const auto& name = path.path().filename().replace_extension().string();
-		auto colorFn = std::make_shared<ColorFunction>(name);
-		
+		GLuint tex;
+		glGenTextures(1, &tex);
+		glBindTexture(GL_TEXTURE_2D, tex);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, previewSize.x, previewSize.y, 0, GL_RGB, GL_UNSIGNED_BYTE, placeholder.data());
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+
+		m_ColorsPreview.emplace_back(tex);
+	}
+
+	m_ColorsName.clear();
+	m_ColorsName.reserve(m_Colors.size());
+	for (const auto& c : m_Colors)
+		m_ColorsName.push_back(c->GetName().c_str());
+
+	// The files are read and parsed by the loader, the previews compiled by
+	// the driver and PollColorFunctions takes them as they finish
+	m_ColorsParseError.assign(paths.size(), std::nullopt);
+	m_ColorsParsed = std::vector<std::atomic<bool>>(paths.size());
+
+	std::vector<uint32_t> tasks(paths.size());
+	std::iota(tasks.begin(), tasks.end(), 0);
+	m_ColorLoader.Run(tasks, [this, paths = std::move(paths)](uint32_t i, uint32_t)
+	{
 		std::optional<std::string> error;
 		try
 		{
-			colorFn->Initialize(std::string(std::istreambuf_iterator<char>(colorSrc), std::istreambuf_iterator<char>()));
-			error = GLCore::Utils::ValidateShader(colorFn->GetSource());
+			std::ifstream colorSrc(paths[i]);
+			m_Colors[i]->Initialize(std::string(std::istreambuf_iterator<char>(colorSrc), std::istreambuf_iterator<char>()));
 		}
 		catch (const custom_error& e)
 		{
@@ -1356,94 +1553,101 @@ void MainLayer::RefreshColorFunctions()
 			error = std::format("Uncatched error: '{}'\nMake sure that uniforms follow the format specified in the documentation.", e.what());
 		}
 
-		m_ColorsError.push_back(error);
-		if (error)
-			LOG_ERROR("{}", error.value());
-		
-		m_Colors.push_back(colorFn);
-	}
+		m_ColorsParseError[i] = std::move(error);
+		m_ColorsParsed[i].store(true, std::memory_order_release);
+	});
 
-	m_ColorsName.clear();
-	m_ColorsName.reserve(m_Colors.size());
-	for (const auto& c : m_Colors)
-		m_ColorsName.push_back(c->GetName().c_str());
+	if (m_SelectedColor >= m_Colors.size())
+		m_SelectedColor = 0;
 
-	// Framebuffer
-	GLuint fb;
-	glGenFramebuffers(1, &fb);
-	glBindFramebuffer(GL_FRAMEBUFFER, fb);
 
-	// Allocate the prevews
-	m_ColorsPreview.reserve(m_Colors.size());
-	for (const auto& [c, error] : std::views::zip(m_Colors, m_ColorsError))
+	SetColorFunction(m_SelectedColor);
+}
+
+void MainLayer::PollColorFunctions()
+{
+	for (size_t i = 0; i < m_Colors.size(); i++)
 	{
-		if (error)
+		ColorPreview& prev = m_ColorsPreview[i];
+
+		if (prev.state == ColorState::Parsing)
 		{
-			m_ColorsPreview.emplace_back(0, 0);
-			continue;
-		}
+			if (!m_ColorsParsed[i].load(std::memory_order_acquire))
+				continue;
 
-		// Make the preview
-		GLuint tex;
-		glGenTextures(1, &tex);
-		glBindTexture(GL_TEXTURE_2D, tex);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, previewSize.x, previewSize.y, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			if (m_ColorsParseError[i])
+			{
+				m_ColorsError[i] = m_ColorsParseError[i];
+				LOG_ERROR("{}", m_ColorsError[i].value());
+				prev.state = ColorState::Done;
+				continue;
+			}
 
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0);
-		GLenum buffers[] = { GL_COLOR_ATTACHMENT0 };
-		glDrawBuffers(1, buffers);
+			prev.pending = StartProgram("color preview", s_PreviewVertexSrc, PreviewSource(*m_Colors[i]));
+			prev.state = ColorState::Compiling;
+		}
 
-		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		if (prev.state == ColorState::Compiling)
 		{
-			LOG_ERROR("Failed to create the color function preview framebuffer");
-			exit(EXIT_FAILURE);
-		}
+			std::string error;
+			if (!PollProgram(prev.pending, error))
+				continue;
 
-		// Shader
-		std::stringstream ss;
-		ss << "#version 400\n\n";
-		ss << c->GetSource() << '\n';
-		ss << R"(
-layout (location = 0) out vec3 outColor;
+			prev.state = ColorState::Done;
+			prev.shaderID = std::exchange(prev.pending.program, 0);
+			if (!prev.shaderID)
+			{
+				m_ColorsError[i] = error;
+				LOG_ERROR("{}", error);
+				continue;
+			}
 
-uniform uint i_Range;
-uniform uvec2 i_Size;
+			glProgramUniform1ui(prev.shaderID, glGetUniformLocation(prev.shaderID, "i_Range"), 100);
+			glProgramUniform2ui(prev.shaderID, glGetUniformLocation(prev.shaderID, "i_Size"), previewSize.x, previewSize.y);
+			m_Colors[i]->SetupShader(prev.shaderID);
 
-void main()
-{
-	int i = int((gl_FragCoord.x / i_Size.x) * i_Range);
-	outColor = get_color(i);
-}
-	)";
+			DrawColorPreview(i);
 
-		GLuint shader = GLCore::Utils::CreateShader(ss.str());
-		glUseProgram(shader);
-		GLint loc;
+			// They got the default one in the meantime
+			if (i == m_SelectedColor)
+				SetColorFunction(i);
 
-		loc = glGetUniformLocation(shader, "i_Range");
-		glUniform1ui(loc, 100);
+			if ((int)i == m_RenderColorIndex && m_RenderColorPending)
+			{
+				m_VideoRenderer.SetColorFunction(m_Colors[i]);
+				m_RenderColorPending = false;
+			}
+		}
+	}
+}
 
-		loc = glGetUniformLocation(shader, "i_Size");
-		glUniform2ui(loc, previewSize.x, previewSize.y);
+void MainLayer::DrawColorPreview(size_t index)
+{
+	GLuint fb;
+	glGenFramebuffers(1, &fb);
+	glBindFramebuffer(GL_FRAMEBUFFER, fb);
 
-		c->UpdateUniformsToShader(shader);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_ColorsPreview[index].textureID, 0);
+	GLenum buffers[] = { GL_COLOR_ATTACHMENT0 };
+	glDrawBuffers(1, buffers);
 
-		// Drawing
-		glViewport(0, 0, previewSize.x, previewSize.y);
-		glDisable(GL_BLEND);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		LOG_ERROR("Failed to create the color function preview framebuffer");
+		exit(EXIT_FAILURE);
+	}
 
-		glBindVertexArray(GLCore::Application::GetDefaultQuadVA());
-		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+	glUseProgram(m_ColorsPreview[index].shaderID);
+	m_Colors[index]->UpdatePreviewUniforms();
 
-		m_ColorsPreview.emplace_back(tex, shader);
-	}
-	glDeleteFramebuffers(1, &fb);
+	glViewport(0, 0, previewSize.x, previewSize.y);
+	glDisable(GL_BLEND);
 
-	if (m_SelectedColor >= m_Colors.size())
-		m_SelectedColor = 0;
+	// See s_PreviewVertexSrc, any vertex array will do
+	glBindVertexArray(GLCore::Application::GetDefaultQuadVA());
+	glDrawArrays(GL_TRIANGLES, 0, 3);
 
+	glDeleteFramebuffers(1, &fb);
 
-	SetColorFunction(m_SelectedColor);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
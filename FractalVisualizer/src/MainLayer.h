@@ -6,6 +6,10 @@
 #include "FractalVisualizer.h"
 #include "VideoRenderer.h"
 #include "ColorFunction.h"
+#include "FrameBudget.h"
+#include "ProgramCache.h"
+#include "TileScheduler.h"
+#include "RenderQueue.h"
 
 struct SmoothZoomData
 {
@@ -13,12 +17,7 @@ struct SmoothZoomData
 	double start_radius;
 	double target_radius;
 	ImVec2 target_pos;
-};
-
-enum class State
-{
-	Exploring = 0,
-	Rendering
+	double wheel_time = -1.0; // Time of the last wheel event
 };
 
 class MainLayer : public GLCore::Layer
@@ -34,15 +33,26 @@ public:
 
 private:
 
+	enum class ColorState
+	{
+		Parsing = 0,
+		Compiling,
+		Done
+	};
+
 	struct ColorPreview
 	{
-		GLuint shaderID;
-		GLuint textureID;
+		GLuint shaderID = 0;
+		GLuint textureID = 0;
+		ColorState state = ColorState::Parsing;
+		PendingProgram pending;
 
-		ColorPreview(GLuint texture, GLuint shader) : textureID(texture), shaderID(shader) {}
+		ColorPreview(GLuint texture) : textureID(texture) {}
 	};
 
 	void RefreshColorFunctions();
+	void PollColorFunctions();
+	void DrawColorPreview(size_t index);
 	bool m_ShouldRefreshColors = false;
 
 	void ShowHelpWindow();
@@ -50,6 +60,7 @@ private:
 	void ShowJuliaWindow();
 	void ShowControlsWindow();
 	void ShowRenderWindow();
+	void ShowRenderQueue();
 	void ShowPreviewWindow();
 
 	bool ShowCenterKeyFrames(const FractalVisualizer& fract);
@@ -58,18 +69,28 @@ private:
 
 	float m_FrameRate = 0;
 	int m_ResolutionPercentage = 100;
+	bool m_DynamicResolution = false;
 	glm::vec3 m_SetColor = { 0.f, 0.f, 0.f };
 	int m_ItersPerSteps = 100;
 	int m_StepsPerFrame = 1;
+	bool m_AutoBudget = false;
+	float m_TargetFrameTime = 16.f; // ms
 	int m_MaxEpochs = 100;
 	int m_FadeThreshold = 0;
 	bool m_SmoothColor = true;
+	bool m_Equalize = false;
 	bool m_SmoothZoom = true;
 	int m_EqExponent = 2;
+	int m_Backend = (int)Backend::Fragment;
+	int m_WorkGroupSize = 64;
+	int m_RenderMode = (int)RenderMode::Full;
 
 	bool m_ShowAnimationCenter = false;
 
-	State m_State = State::Exploring;
+	// Image and video renders, they run after the views every frame
+	RenderQueue m_RenderQueue;
+	float m_JobFrameTime = 8.f; // ms
+	int m_JobPriority = 0;
 
 	bool m_ShouldUpdatePreview = true;
 	float m_PreviewT = 0.0;
@@ -85,6 +106,13 @@ private:
 	std::vector<std::optional<std::string>> m_ColorsError;
 	std::vector<const char*> m_ColorsName;
 	size_t m_SelectedColor = 0;
+	bool m_RenderColorPending = false; // The video renderer got the default while it loads
+
+	// Reads and parses the color function files, only PollColorFunctions
+	// looks at the results, once their flag is set
+	TileScheduler m_ColorLoader;
+	std::vector<std::optional<std::string>> m_ColorsParseError;
+	std::vector<std::atomic<bool>> m_ColorsParsed;
 
 	std::shared_ptr<ColorFunction> SetColorFunction(size_t index);
 	std::shared_ptr<ColorFunction> GetColorFunction(size_t index) const;
@@ -99,11 +127,13 @@ private:
 	//glm::dvec2 m_MandelbrotZ = { 0, 0 };
 	std::string m_MandelbrotSrcPath;
 	FractalVisualizer m_Mandelbrot;
+	FrameBudget m_MandelbrotBudget;
 
 	SmoothZoomData m_JuliaZoomData;
 	bool m_JuliaMinimized = true;
 	glm::dvec2 m_JuliaC = { 0, 0 };
 	std::string m_JuliaSrcPath;
 	FractalVisualizer m_Julia;
+	FrameBudget m_JuliaBudget;
 };
 
@@ -0,0 +1,158 @@
+#include "MarianiSilver.h"
+#include "ComputeShader.h"
+
+// One invocation per tile. The flags match the ones in the fractal shaders.
+static const char* s_RefineSrc = R"(#version 430 core
+layout (local_size_x = 8, local_size_y = 8) in;
+
+layout (binding = 1, rgba32ui) uniform uimage2D i_Iter;
+layout (binding = 2, rgba32f) uniform image2D i_Samples;
+
+layout (location = 0) uniform uvec2 i_Size;
+layout (location = 1) uniform uint i_Tile;
+
+layout (std430, binding = 3) buffer GuessStats
+{
+    uint guessed;
+    uint computed;
+};
+
+#define PIXEL_INTERIOR 1u
+#define PIXEL_PENDING 2u
+#define PIXEL_GUESSED 4u
+#define PIXEL_START 8u
+
+// Iterations to the first escape, offset by 2. Interior pixels are 1 and the
+// ones that are not done yet 0, which never matches.
+uint pixel_class(ivec2 p)
+{
+    uvec4 iter = imageLoad(i_Iter, p);
+    if (iter.x > 0)
+        return iter.z + 2;
+    if ((iter.w & PIXEL_INTERIOR) != 0)
+        return 1;
+    return 0;
+}
+
+bool schedule(ivec2 p)
+{
+    if (imageLoad(i_Iter, p).w != PIXEL_PENDING)
+        return false;
+
+    imageStore(i_Iter, p, uvec4(0, 0, 0, PIXEL_START));
+    return true;
+}
+
+void main()
+{
+    ivec2 tile0 = ivec2(gl_GlobalInvocationID.xy * i_Tile);
+    ivec2 tile1 = min(tile0 + int(i_Tile), ivec2(i_Size) - 1);
+
+    // Nothing in between the borders, or already handled by a larger tile
+    if (any(lessThan(tile1 - tile0, ivec2(2))))
+        return;
+    if (imageLoad(i_Iter, tile0 + 1).w != PIXEL_PENDING)
+        return;
+
+    uint tile_class = pixel_class(tile0);
+    bool uniform_border = tile_class != 0;
+    for (int x = tile0.x; x <= tile1.x && uniform_border; x++)
+        uniform_border = pixel_class(ivec2(x, tile0.y)) == tile_class && pixel_class(ivec2(x, tile1.y)) == tile_class;
+    for (int y = tile0.y; y <= tile1.y && uniform_border; y++)
+        uniform_border = pixel_class(ivec2(tile0.x, y)) == tile_class && pixel_class(ivec2(tile1.x, y)) == tile_class;
+
+    if (uniform_border)
+    {
+        vec4 s00 = imageLoad(i_Samples, tile0);
+        vec4 s10 = imageLoad(i_Samples, ivec2(tile1.x, tile0.y));
+        vec4 s01 = imageLoad(i_Samples, ivec2(tile0.x, tile1.y));
+        vec4 s11 = imageLoad(i_Samples, tile1);
+
+        for (int y = tile0.y + 1; y < tile1.y; y++)
+        {
+            for (int x = tile0.x + 1; x < tile1.x; x++)
+            {
+                vec2 t = vec2(ivec2(x, y) - tile0) / vec2(tile1 - tile0);
+                vec4 samples = mix(mix(s00, s10, t.x), mix(s01, s11, t.x), t.y);
+
+                imageStore(i_Samples, ivec2(x, y), samples);
+                imageStore(i_Iter, ivec2(x, y), uvec4(0, 0, 0, PIXEL_GUESSED));
+            }
+        }
+
+        atomicAdd(guessed, uint((tile1.x - tile0.x - 1) * (tile1.y - tile0.y - 1)));
+        return;
+    }
+
+    // Split in four, the midlines are computed from the next step on
+    ivec2 mid = tile0 + int(i_Tile / 2);
+    uint scheduled = 0;
+    if (mid.x < tile1.x)
+    {
+        for (int y = tile0.y + 1; y < tile1.y; y++)
+            scheduled += schedule(ivec2(mid.x, y)) ? 1 : 0;
+    }
+    if (mid.y < tile1.y)
+    {
+        for (int x = tile0.x + 1; x < tile1.x; x++)
+            scheduled += schedule(ivec2(x, mid.y)) ? 1 : 0;
+    }
+
+    atomicAdd(computed, scheduled);
+}
+)";
+
+MarianiSilver::MarianiSilver()
+{
+	m_Program = CreateComputeShader(s_RefineSrc);
+
+	glGenBuffers(1, &m_StatsBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_StatsBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(Stats), nullptr, GL_DYNAMIC_READ);
+}
+
+MarianiSilver::~MarianiSilver()
+{
+	glDeleteProgram(m_Program);
+	glDeleteBuffers(1, &m_StatsBuffer);
+}
+
+void MarianiSilver::Start(uint32_t gridPixels)
+{
+	Stats stats;
+	stats.computed = gridPixels;
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_StatsBuffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(Stats), &stats);
+}
+
+void MarianiSilver::Refine(const glm::uvec2& size, uint32_t tileSize)
+{
+	const glm::uvec2 tiles = (size - 1u + tileSize - 1u) / tileSize;
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, StatsBinding, m_StatsBuffer);
+	glProgramUniform2ui(m_Program, 0, size.x, size.y);
+	glProgramUniform1ui(m_Program, 1, tileSize);
+
+	glUseProgram(m_Program);
+	glDispatchCompute((tiles.x + 7) / 8, (tiles.y + 7) / 8, 1);
+	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+}
+
+MarianiSilver::Stats MarianiSilver::ReadStats() const
+{
+	Stats stats;
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_StatsBuffer);
+	glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(Stats), &stats);
+	return stats;
+}
+
+uint32_t MarianiSilver::GridPixels(const glm::uvec2& size, uint32_t tileSize)
+{
+	// Lines at the multiples of the tile size plus the last one
+	auto lines = [tileSize](uint32_t n) { return (n + tileSize - 1) / tileSize + ((n - 1) % tileSize != 0 ? 1 : 0); };
+
+	const uint32_t cols = lines(size.x);
+	const uint32_t rows = lines(size.y);
+	return cols * size.y + rows * size.x - cols * rows;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <GLCore.h>
+
+// Mariani-Silver style solid area guessing for the compute backend. The first
+// steps only compute the grid of the coarsest tiles, the pixels in between are
+// left pending. Every refinement looks at the border of each pending tile:
+// if all of it escaped at the same iteration (or is interior) the tile is
+// filled from its corners, otherwise its midlines are scheduled for computing
+// and the halves are looked at by the next refinement.
+class MarianiSilver
+{
+public:
+	struct Stats
+	{
+		uint32_t guessed = 0;
+		uint32_t computed = 0;
+	};
+
+	MarianiSilver();
+	~MarianiSilver();
+
+	// Resets the counters, `gridPixels` are computed from the start
+	void Start(uint32_t gridPixels);
+
+	// Guesses or splits the pending tiles of `tileSize`. Works on the iteration
+	// state bound to image unit `IterUnit` and the samples bound to `SamplesUnit`.
+	void Refine(const glm::uvec2& size, uint32_t tileSize);
+
+	// Waits for the GPU, only meant to be called once the guessing is over
+	Stats ReadStats() const;
+
+	// Pixels on the grid of `tileSize`, including the last row and column
+	static uint32_t GridPixels(const glm::uvec2& size, uint32_t tileSize);
+
+	static constexpr GLuint IterUnit = 1;
+	static constexpr GLuint SamplesUnit = 2;
+	static constexpr GLuint StatsBinding = 3;
+
+private:
+	GLuint m_Program = 0;
+	GLuint m_StatsBuffer = 0;
+};
@@ -0,0 +1,73 @@
+#include "Perturbation.h"
+
+static glm::dvec2 mul(const glm::dvec2& a, const glm::dvec2& b)
+{
+	return { a.x*b.x-a.y*b.y, a.x*b.y+a.y*b.x };
+}
+
+std::vector<glm::dvec2> ComputeReferenceOrbit(BigComplex z, const BigComplex& c, int exponent, size_t maxLength)
+{
+	// Also keeps z^exponent inside the integer limb
+	const double bailout = std::min(4.0, std::exp2(60.0 / exponent));
+
+	std::vector<glm::dvec2> orbit;
+	while (true)
+	{
+		glm::dvec2 value = z.ToDouble();
+		orbit.push_back(value);
+
+		if (orbit.size() >= maxLength || glm::dot(value, value) > bailout)
+			break;
+
+		BigComplex next = z.Square();
+		for (int i = 2; i < exponent; i++)
+			next = next * z;
+
+		z = next + c;
+	}
+	return orbit;
+}
+
+void ComputeSeries(ReferenceOrbit& ref, bool julia, int exponent, double scale)
+{
+	// Largest neglected term relative to the linear one
+	constexpr double tolerance = 1e-12;
+
+	glm::dvec2 a = { julia ? 1.0 : 0.0, 0.0 };
+	glm::dvec2 b = { 0.0, 0.0 };
+	glm::dvec2 c = { 0.0, 0.0 };
+	glm::dvec2 d = { 0.0, 0.0 }; // Not used by the shaders, only to know when to stop
+	uint32_t skip = 0;
+
+	// The terms are only derived for z^2 + c
+	for (size_t n = 0; exponent == 2 && n + 1 < ref.orbit.size(); n++)
+	{
+		glm::dvec2 Z2 = 2.0 * ref.orbit[n];
+
+		glm::dvec2 na = mul(Z2, a) + glm::dvec2(julia ? 0.0 : 1.0, 0.0);
+		glm::dvec2 nb = mul(Z2, b) + mul(a, a) * scale;
+		glm::dvec2 nc = mul(Z2, c) + 2.0 * mul(a, b) * scale;
+		glm::dvec2 nd = mul(Z2, d) + (mul(b, b) + 2.0 * mul(a, c)) * scale;
+
+		// The linear term vanishes when a julia reference goes through 0, so
+		// the fourth order one has to be checked too
+		if (glm::length(nc) + glm::length(nd) > tolerance * glm::length(na))
+			break;
+
+		// No pixel can escape while being skipped
+		if (glm::length(ref.orbit[n + 1]) + scale * (glm::length(na) + glm::length(nb) + glm::length(nc)) > 2.0)
+			break;
+
+		a = na;
+		b = nb;
+		c = nc;
+		d = nd;
+		skip = (uint32_t)n + 1;
+	}
+
+	ref.seriesSkip = skip;
+	ref.seriesA = a;
+	ref.seriesB = b;
+	ref.seriesC = c;
+	ref.seriesScale = scale;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <GLCore.h>
+
+#include "BigFloat.h"
+
+// Orbit of a single high precision point. In deep zooms every pixel only
+// iterates its (small) difference to it, see the PERTURBATION shader path.
+struct ReferenceOrbit
+{
+	std::vector<glm::dvec2> orbit;
+
+	// Deltas after `seriesSkip` iterations are approximated by
+	// dz = scale * (A u + B u^2 + C u^3), where u = d / scale
+	uint32_t seriesSkip = 0;
+	glm::dvec2 seriesA = { 0.0, 0.0 };
+	glm::dvec2 seriesB = { 0.0, 0.0 };
+	glm::dvec2 seriesC = { 0.0, 0.0 };
+	double seriesScale = 1.0;
+};
+
+// Iterates z^exponent + c starting at `z` until it escapes or `maxLength` points are computed
+std::vector<glm::dvec2> ComputeReferenceOrbit(BigComplex z, const BigComplex& c, int exponent, size_t maxLength);
+
+// Finds how many iterations can be skipped for offsets up to `scale` from the
+// reference point. In julia sets the offset is applied to z instead of c.
+void ComputeSeries(ReferenceOrbit& ref, bool julia, int exponent, double scale);
@@ -0,0 +1,296 @@
+#include "ProgramCache.h"
+
+#include <GLCoreUtils.h>
+
+#include <filesystem>
+#include <fstream>
+#include <format>
+#include <unordered_map>
+
+namespace
+{
+	struct ProgramBinary
+	{
+		GLenum format = 0;
+		uint64_t sourceSize = 0; // Guards against hash collisions
+		std::vector<uint8_t> data;
+	};
+
+	// Start of every file
+	struct FileHeader
+	{
+		uint32_t magic;
+		uint32_t format;
+		uint64_t sourceSize;
+		uint64_t dataSize;
+	};
+
+	constexpr uint32_t FileMagic = 0x42505646; // "FVPB"
+}
+
+static std::unordered_map<uint64_t, ProgramBinary> s_Binaries;
+
+// FNV-1a, stable between runs unlike std::hash
+static uint64_t Hash(std::string_view data, uint64_t hash = 14695981039346656037ull)
+{
+	for (char c : data)
+	{
+		hash ^= (uint8_t)c;
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+static bool IsSupported()
+{
+	static const bool supported = [] {
+		GLint formats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		return formats > 0;
+	}();
+	return supported;
+}
+
+static uint64_t ProgramKey(const char* kind, const std::string& source)
+{
+	// Binaries are only valid for the driver that made them
+	static const std::string driver = std::format("{}\n{}\n{}\n",
+		(const char*)glGetString(GL_VENDOR), (const char*)glGetString(GL_RENDERER), (const char*)glGetString(GL_VERSION));
+
+	return Hash(source, Hash(kind, Hash(driver)));
+}
+
+static std::filesystem::path BinaryPath(uint64_t key)
+{
+	return std::filesystem::path(ProgramCacheDirectory) / std::format("{:016x}.bin", key);
+}
+
+// Looks in memory first and then on disk, null if neither has it
+static const ProgramBinary* FindBinary(uint64_t key, size_t sourceSize)
+{
+	if (auto it = s_Binaries.find(key); it != s_Binaries.end())
+		return it->second.sourceSize == sourceSize ? &it->second : nullptr;
+
+	std::ifstream file(BinaryPath(key), std::ios::binary);
+	if (!file)
+		return nullptr;
+
+	FileHeader header;
+	if (!file.read((char*)&header, sizeof(header)) || header.magic != FileMagic || header.sourceSize != sourceSize)
+		return nullptr;
+
+	ProgramBinary binary;
+	binary.format = header.format;
+	binary.sourceSize = header.sourceSize;
+	binary.data.resize(header.dataSize);
+	if (!file.read((char*)binary.data.data(), binary.data.size()))
+		return nullptr;
+
+	return &(s_Binaries[key] = std::move(binary));
+}
+
+static void StoreBinary(uint64_t key, size_t sourceSize, GLuint program)
+{
+	// Not every driver hands them out
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length == 0)
+		return;
+
+	ProgramBinary binary;
+	binary.sourceSize = sourceSize;
+	binary.data.resize(length);
+	glGetProgramBinary(program, length, &length, &binary.format, binary.data.data());
+	binary.data.resize(length);
+
+	// Without the directory the binaries only last until the program closes
+	std::error_code error;
+	std::filesystem::create_directories(ProgramCacheDirectory, error);
+
+	std::ofstream file(BinaryPath(key), std::ios::binary);
+	if (!error && file)
+	{
+		FileHeader header = { FileMagic, binary.format, binary.sourceSize, binary.data.size() };
+		file.write((const char*)&header, sizeof(header));
+		file.write((const char*)binary.data.data(), binary.data.size());
+	}
+	else
+		LOG_WARN("Could not write the program binary {0}", BinaryPath(key).string());
+
+	s_Binaries[key] = std::move(binary);
+}
+
+static void ForgetBinary(uint64_t key)
+{
+	s_Binaries.erase(key);
+
+	std::error_code error;
+	std::filesystem::remove(BinaryPath(key), error);
+}
+
+// Null if the binary is missing or the driver rejects it
+static GLuint LoadProgram(uint64_t key, size_t sourceSize)
+{
+	const ProgramBinary* binary = FindBinary(key, sourceSize);
+	if (!binary)
+		return 0;
+
+	GLuint program = glCreateProgram();
+	glProgramBinary(program, binary->format, binary->data.data(), (GLsizei)binary->data.size());
+
+	GLint status;
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+	if (status == GL_TRUE)
+		return program;
+
+	// Usually a driver update that kept the same version string
+	glDeleteProgram(program);
+	ForgetBinary(key);
+	return 0;
+}
+
+GLuint GetCachedProgram(const char* kind, const std::string& source, ProgramBuilder build)
+{
+	if (!IsSupported())
+		return build(source);
+
+	const uint64_t key = ProgramKey(kind, source);
+	if (GLuint program = LoadProgram(key, source.size()))
+		return program;
+
+	GLuint program = build(source);
+	StoreBinary(key, source.size(), program);
+	return program;
+}
+
+static GLuint BuildShader(const std::string& source)
+{
+	return GLCore::Utils::CreateShader(source);
+}
+
+GLuint CreateCachedShader(const std::string& source)
+{
+	return GetCachedProgram("vertex+fragment", source, BuildShader);
+}
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+static bool HasParallelCompile()
+{
+	static const bool supported = [] {
+		GLint count = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+		for (GLint i = 0; i < count; i++)
+		{
+			std::string_view name = (const char*)glGetStringi(GL_EXTENSIONS, i);
+			if (name == "GL_KHR_parallel_shader_compile" || name == "GL_ARB_parallel_shader_compile")
+				return true;
+		}
+		return false;
+	}();
+	return supported;
+}
+
+PendingProgram StartProgram(const char* kind, const std::string& vertexSrc, const std::string& fragmentSrc)
+{
+	PendingProgram pending;
+	pending.sourceSize = vertexSrc.size() + fragmentSrc.size();
+
+	if (IsSupported())
+	{
+		pending.key = ProgramKey(kind, vertexSrc + fragmentSrc);
+		if ((pending.program = LoadProgram(pending.key, pending.sourceSize)))
+			return pending;
+	}
+
+	// Neither call waits for the compiler with the extension
+	const std::string* sources[] = { &vertexSrc, &fragmentSrc };
+	const GLenum types[] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+
+	pending.program = glCreateProgram();
+	glProgramParameteri(pending.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	for (int i = 0; i < 2; i++)
+	{
+		pending.shaders[i] = glCreateShader(types[i]);
+		const char* src = sources[i]->c_str();
+		glShaderSource(pending.shaders[i], 1, &src, nullptr);
+		glCompileShader(pending.shaders[i]);
+		glAttachShader(pending.program, pending.shaders[i]);
+	}
+	glLinkProgram(pending.program);
+
+	return pending;
+}
+
+bool PollProgram(PendingProgram& pending, std::string& error)
+{
+	// Loaded from the cache
+	if (pending.shaders[0] == 0)
+		return true;
+
+	if (HasParallelCompile())
+	{
+		GLint done;
+		glGetProgramiv(pending.program, GL_COMPLETION_STATUS_KHR, &done);
+		if (done == GL_FALSE)
+			return false;
+	}
+
+	GLint status;
+	glGetProgramiv(pending.program, GL_LINK_STATUS, &status);
+	if (status == GL_FALSE)
+	{
+		// The compile log says more than the link one
+		for (GLuint shader : pending.shaders)
+		{
+			GLint compiled, length;
+			glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+			glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+			if (compiled == GL_FALSE && length > 0)
+			{
+				error.resize(length);
+				glGetShaderInfoLog(shader, length, &length, error.data());
+				error.resize(length);
+				break;
+			}
+		}
+
+		if (error.empty())
+		{
+			GLint length;
+			glGetProgramiv(pending.program, GL_INFO_LOG_LENGTH, &length);
+			error.resize(length);
+			glGetProgramInfoLog(pending.program, length, &length, error.data());
+			error.resize(length);
+		}
+
+	}
+	else if (IsSupported())
+		StoreBinary(pending.key, pending.sourceSize, pending.program);
+
+	for (GLuint& shader : pending.shaders)
+	{
+		glDetachShader(pending.program, shader);
+		glDeleteShader(shader);
+		shader = 0;
+	}
+
+	if (status == GL_FALSE)
+	{
+		glDeleteProgram(pending.program);
+		pending.program = 0;
+	}
+
+	return true;
+}
+
+void CancelProgram(PendingProgram& pending)
+{
+	for (GLuint shader : pending.shaders)
+		glDeleteShader(shader);
+
+	glDeleteProgram(pending.program);
+	pending = {};
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <GLCore.h>
+
+// Every program built from source is kept as a binary, keyed by a hash of its
+// source and of the driver, in memory and in `ProgramCacheDirectory`. The
+// source already holds everything that makes a program, the fractal, the
+// color function and the defines, so asking for the same one again, even
+// after a restart, loads the binary instead of invoking the GLSL compiler.
+// Binaries the driver no longer accepts are built again. The callers own the
+// programs returned, like the ones built from source.
+
+// Relative to the working directory, like the assets
+inline constexpr const char* ProgramCacheDirectory = "cache/programs";
+
+using ProgramBuilder = GLuint(*)(const std::string& source);
+
+// Returns the program `build` makes of `source`. `kind` tells apart the
+// builders that would make different programs of the same source.
+GLuint GetCachedProgram(const char* kind, const std::string& source, ProgramBuilder build);
+
+// GLCore::Utils::CreateShader through the cache
+GLuint CreateCachedShader(const std::string& source);
+
+// A vertex + fragment program being built without waiting for the driver
+struct PendingProgram
+{
+	GLuint program = 0;
+	GLuint shaders[2] = {};
+	uint64_t key = 0;
+	size_t sourceSize = 0;
+};
+
+// Cached programs are loaded right away. The rest are compiled and linked by
+// the driver in the background if it supports KHR_parallel_shader_compile,
+// otherwise the first PollProgram waits for them.
+PendingProgram StartProgram(const char* kind, const std::string& vertexSrc, const std::string& fragmentSrc);
+
+// False while the driver is still busy. Once done, `program` is either the
+// linked program, or 0 with the log in `error`.
+bool PollProgram(PendingProgram& pending, std::string& error);
+
+// Deletes whatever `pending` still holds, done or not
+void CancelProgram(PendingProgram& pending);
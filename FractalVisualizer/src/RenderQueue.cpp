@@ -0,0 +1,120 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+
+// Longest frame counted in the time of a job, the rest was not spent on it
+static const double MAX_FRAME_TIME = 0.5;
+
+static void WaitFence(GLsync fence)
+{
+	// The flush makes sure the fence gets to the GPU at all
+	while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000'000) == GL_TIMEOUT_EXPIRED);
+	glDeleteSync(fence);
+}
+
+double RenderQueue::Job::GetEta() const
+{
+	if (progress <= 0.f || IsFinished())
+		return -1.0;
+
+	return elapsed * (1.0 - progress) / progress;
+}
+
+uint64_t RenderQueue::Push(std::string name, int priority, std::unique_ptr<RenderTask> task)
+{
+	Job& job = m_Jobs.emplace_back();
+	job.id = m_NextId++;
+	job.name = std::move(name);
+	job.priority = priority;
+	job.task = std::move(task);
+	return job.id;
+}
+
+void RenderQueue::Cancel(uint64_t id)
+{
+	Job* job = Find(id);
+	if (!job || job->IsFinished())
+		return;
+
+	job->state = JobState::Cancelled;
+	job->task.reset();
+}
+
+void RenderQueue::SetPriority(uint64_t id, int priority)
+{
+	if (Job* job = Find(id))
+		job->priority = priority;
+}
+
+void RenderQueue::ClearFinished()
+{
+	std::erase_if(m_Jobs, [](const Job& job) { return job.IsFinished(); });
+}
+
+bool RenderQueue::IsBusy() const
+{
+	return std::ranges::any_of(m_Jobs, [](const Job& job) { return !job.IsFinished(); });
+}
+
+RenderQueue::Job* RenderQueue::Find(uint64_t id)
+{
+	auto it = std::ranges::find(m_Jobs, id, &Job::id);
+	return it != m_Jobs.end() ? &*it : nullptr;
+}
+
+RenderQueue::Job* RenderQueue::Next()
+{
+	// The jobs are in the order they were pushed
+	Job* next = nullptr;
+	for (Job& job : m_Jobs)
+	{
+		if (!job.IsFinished() && (!next || job.priority > next->priority))
+			next = &job;
+	}
+	return next;
+}
+
+void RenderQueue::Run(double budget)
+{
+	const Clock::time_point start = Clock::now();
+	const double frame = std::min(std::chrono::duration<double>(start - m_LastRun).count(), MAX_FRAME_TIME);
+	m_LastRun = start;
+
+	// The job of this frame gets its time, the one it took over from stays paused
+	if (Job* job = Next(); job && job->state == JobState::Running)
+		job->elapsed += frame;
+
+	GLsync inFlight = nullptr;
+	while (std::chrono::duration<double, std::milli>(Clock::now() - start).count() < budget)
+	{
+		Job* job = Next();
+		if (!job)
+			break;
+
+		job->state = JobState::Running;
+		const RenderTask::Status status = job->task->Step();
+		job->progress = job->task->GetProgress();
+
+		GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		if (inFlight)
+			WaitFence(inFlight);
+		inFlight = fence;
+
+		if (status == RenderTask::Status::Done)
+		{
+			job->state = JobState::Done;
+			job->progress = 1.f;
+			job->task.reset();
+		}
+		else if (status == RenderTask::Status::Failed)
+		{
+			job->state = JobState::Failed;
+			job->task.reset();
+		}
+		else if (status == RenderTask::Status::Waiting)
+			break;
+	}
+
+	if (inFlight)
+		WaitFence(inFlight);
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <GLCore.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+// A render that runs a step at a time, see RenderQueue
+class RenderTask
+{
+public:
+	enum class Status
+	{
+		Running = 0,
+		Waiting, // The step runs in the background, nothing to do until the next frame
+		Done,
+		Failed
+	};
+
+	virtual ~RenderTask() = default;
+
+	virtual Status Step() = 0;
+
+	// From 0 to 1
+	virtual float GetProgress() const = 0;
+};
+
+// Runs the queued renders for a given time every frame, so they neither
+// freeze the UI nor are paced by it: a slice runs as many steps as fit, be it
+// a fraction of one or hundreds. Only the job with the highest priority runs,
+// the oldest one first among equals, so a job pushed with a higher priority
+// takes over at the next slice and the other one goes on once it is done.
+//
+// A step is only queued once the one before the last has finished on the
+// GPU. The slice measures the GPU time of its steps instead of how fast they
+// were queued, and the views drawn after it never wait for more than one.
+class RenderQueue
+{
+public:
+	enum class JobState
+	{
+		Queued = 0,
+		Running,
+		Done,
+		Failed,
+		Cancelled
+	};
+
+	struct Job
+	{
+		uint64_t id = 0;
+		std::string name;
+		int priority = 0;
+		JobState state = JobState::Queued;
+		float progress = 0.f;
+		double elapsed = 0.0; // Seconds of the frames it ran in
+		std::unique_ptr<RenderTask> task; // Freed once it ends
+
+		bool IsFinished() const { return state != JobState::Queued && state != JobState::Running; }
+
+		// Seconds left at the pace so far, negative until there is one
+		double GetEta() const;
+	};
+
+	uint64_t Push(std::string name, int priority, std::unique_ptr<RenderTask> task);
+
+	void Cancel(uint64_t id);
+	void SetPriority(uint64_t id, int priority);
+
+	// Removes the jobs that are done, failed or were cancelled
+	void ClearFinished();
+
+	// Runs the jobs for `budget` milliseconds
+	void Run(double budget);
+
+	bool IsBusy() const;
+	const std::vector<Job>& GetJobs() const { return m_Jobs; }
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	Job* Find(uint64_t id);
+	Job* Next();
+
+	std::vector<Job> m_Jobs;
+	uint64_t m_NextId = 1;
+
+	Clock::time_point m_LastRun;
+};
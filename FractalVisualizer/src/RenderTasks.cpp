@@ -0,0 +1,93 @@
+#include "RenderTasks.h"
+
+#include <GLCoreUtils.h>
+
+#include <algorithm>
+
+ImageRenderTask::ImageRenderTask(const std::filesystem::path& fractal, const FractalVisualizer& settings, const View& view, std::string fileName)
+	: m_Fractal(std::make_unique<FractalVisualizer>(fractal))
+	, m_Steps(view.steps)
+	, m_FileName(std::move(fileName))
+{
+	m_Fractal->CopySettings(settings);
+
+	// Its uniforms can be edited while the job waits
+	m_Fractal->SetColorFunction(std::make_shared<ColorFunction>(*settings.GetColorFunction()));
+	m_Fractal->SetJuliaC(settings.GetJuliaC());
+
+	m_Fractal->SetCenter(view.center);
+	m_Fractal->SetRadius(view.radius);
+	m_Fractal->SetSize(view.resolution);
+	m_Fractal->SetIterationsPerFrame(view.iterations);
+
+	m_Fractal->SetPreview(false);
+	m_Fractal->SetDynamicResolution(false);
+	m_Fractal->ResetRender();
+}
+
+RenderTask::Status ImageRenderTask::Step()
+{
+	// Pending pixels would show up as the set color, and the last ones the
+	// guessing left to compute need their steps too
+	if (!m_Fractal->HasRunSteps(m_Steps))
+	{
+		// The CPU backend only starts the next step once the last one is done
+		m_Fractal->Update();
+		return m_Fractal->GetBackend() == Backend::Cpu ? Status::Waiting : Status::Running;
+	}
+
+	// Waits for the last step of the CPU backend
+	m_Fractal->Finish();
+
+	if (m_Fractal->GetRenderMode() == RenderMode::Guessing && m_Fractal->GetBackend() == Backend::Compute && !m_Fractal->GetPerturbation())
+	{
+		MarianiSilver::Stats stats = m_Fractal->GetGuessStats();
+		LOG_INFO("Guessed {} and computed {} pixels", stats.guessed, stats.computed);
+	}
+
+	if (!GLCore::Utils::ExportTexture(m_Fractal->GetTexture(), m_FileName, true))
+	{
+		LOG_ERROR("Failed to write '{}'", m_FileName);
+		return Status::Failed;
+	}
+	return Status::Done;
+}
+
+float ImageRenderTask::GetProgress() const
+{
+	// Guessing may take a few steps more
+	return std::min(m_Fractal->GetFrame() / (float)m_Steps, 0.99f);
+}
+
+VideoRenderTask::VideoRenderTask(const VideoRenderer& editor, const std::filesystem::path& fractal, const FractalVisualizer& settings)
+{
+	m_Video.CopySettings(editor);
+	m_Video.Prepare(fractal, settings);
+
+	double dt = m_Video.duration / (double)m_Video.steps;
+	m_Video.InvalidateRadius(dt * 1e-3);
+	m_Video.InvalidateCenter();
+}
+
+RenderTask::Status VideoRenderTask::Step()
+{
+	// ffmpeg only starts with the job
+	if (!m_Encoding)
+	{
+		if (!m_Video.BeginEncoding())
+			return Status::Failed;
+		m_Encoding = true;
+	}
+
+	switch (m_Video.EncodeFrame())
+	{
+	case EncodeStatus::Running: return Status::Running;
+	case EncodeStatus::Done:    return Status::Done;
+	default:                    return Status::Failed;
+	}
+}
+
+float VideoRenderTask::GetProgress() const
+{
+	return m_Video.current_iter / (float)m_Video.steps;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "RenderQueue.h"
+#include "FractalVisualizer.h"
+#include "VideoRenderer.h"
+
+// Renders a still with a fractal of its own and saves it. The settings are
+// copied when it is made, so the views can keep changing while it waits.
+class ImageRenderTask : public RenderTask
+{
+public:
+	struct View
+	{
+		glm::dvec2 center = { 0.0, 0.0 };
+		double radius = 1.0;
+		glm::uvec2 resolution = { 1920, 1080 };
+		int steps = 200;
+		int iterations = 100;
+	};
+
+	ImageRenderTask(const std::filesystem::path& fractal, const FractalVisualizer& settings, const View& view, std::string fileName);
+
+	Status Step() override;
+	float GetProgress() const override;
+
+private:
+	std::unique_ptr<FractalVisualizer> m_Fractal;
+	int m_Steps;
+	std::string m_FileName;
+};
+
+// Renders and encodes the video of a copy of the key frames
+class VideoRenderTask : public RenderTask
+{
+public:
+	VideoRenderTask(const VideoRenderer& editor, const std::filesystem::path& fractal, const FractalVisualizer& settings);
+
+	Status Step() override;
+	float GetProgress() const override;
+
+private:
+	VideoRenderer m_Video;
+	bool m_Encoding = false;
+};
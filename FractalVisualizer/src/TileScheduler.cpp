@@ -0,0 +1,127 @@
+#include "TileScheduler.h"
+
+TileScheduler::TileScheduler(uint32_t threadCount)
+	: m_Queues(std::max(threadCount, 1u))
+{
+	m_Threads.reserve(m_Queues.size());
+	for (uint32_t i = 0; i < (uint32_t)m_Queues.size(); i++)
+		m_Threads.emplace_back(&TileScheduler::Work, this, i);
+}
+
+TileScheduler::~TileScheduler()
+{
+	Cancel();
+
+	{
+		std::lock_guard lock(m_Mutex);
+		m_Stop = true;
+	}
+	m_Wake.notify_all();
+
+	for (auto& thread : m_Threads)
+		thread.join();
+}
+
+void TileScheduler::Run(const std::vector<uint32_t>& tasks, Task task)
+{
+	Wait();
+	if (tasks.empty())
+		return;
+
+	std::lock_guard lock(m_Mutex);
+	m_Task = std::move(task);
+	m_Pending.store(tasks.size(), std::memory_order_release);
+
+	// Dealt like cards, so every worker starts with some of the first tasks
+	for (size_t i = 0; i < tasks.size(); i++)
+	{
+		Queue& queue = m_Queues[i % m_Queues.size()];
+		std::lock_guard queueLock(queue.mutex);
+		queue.tasks.push_back(tasks[i]);
+	}
+
+	m_Generation++;
+	m_Wake.notify_all();
+}
+
+void TileScheduler::Cancel()
+{
+	size_t dropped = 0;
+	for (auto& queue : m_Queues)
+	{
+		std::lock_guard lock(queue.mutex);
+		dropped += queue.tasks.size();
+		queue.tasks.clear();
+	}
+	if (dropped > 0)
+		Finished(dropped);
+
+	Wait();
+}
+
+void TileScheduler::Wait()
+{
+	std::unique_lock lock(m_Mutex);
+	m_Done.wait(lock, [&] { return m_Pending.load(std::memory_order_acquire) == 0; });
+}
+
+void TileScheduler::Work(uint32_t thread)
+{
+	uint64_t generation = 0;
+	while (true)
+	{
+		{
+			std::unique_lock lock(m_Mutex);
+			m_Wake.wait(lock, [&] { return m_Stop || m_Generation != generation; });
+			if (m_Stop)
+				return;
+			generation = m_Generation;
+		}
+
+		uint32_t task;
+		while (Take(thread, task))
+		{
+			m_Task(task, thread);
+			Finished(1);
+		}
+	}
+}
+
+bool TileScheduler::Take(uint32_t thread, uint32_t& task)
+{
+	{
+		Queue& own = m_Queues[thread];
+		std::lock_guard lock(own.mutex);
+		if (!own.tasks.empty())
+		{
+			task = own.tasks.front();
+			own.tasks.pop_front();
+			return true;
+		}
+	}
+
+	// Steal the last task of someone else, the one its owner would run last
+	const size_t count = m_Queues.size();
+	for (size_t i = 1; i < count; i++)
+	{
+		Queue& victim = m_Queues[(thread + i) % count];
+		std::lock_guard lock(victim.mutex);
+		if (!victim.tasks.empty())
+		{
+			task = victim.tasks.back();
+			victim.tasks.pop_back();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void TileScheduler::Finished(size_t count)
+{
+	if (m_Pending.fetch_sub(count, std::memory_order_acq_rel) == count)
+	{
+		std::lock_guard lock(m_Mutex);
+		m_Done.notify_all();
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs batches of tasks on a fixed set of worker threads. Every worker owns a
+// deque, taking tasks from the front of its own and, once it is empty,
+// stealing from the back of the others. The cost of a tile can differ by
+// orders of magnitude, so the threads that got cheap ones end up helping with
+// the expensive ones instead of waiting.
+class TileScheduler
+{
+public:
+	// Called with the task and the index of the worker running it
+	using Task = std::function<void(uint32_t task, uint32_t thread)>;
+
+	TileScheduler(uint32_t threadCount = std::thread::hardware_concurrency());
+	~TileScheduler();
+
+	TileScheduler(const TileScheduler&) = delete;
+	TileScheduler& operator=(const TileScheduler&) = delete;
+
+	// Starts running the tasks and returns right away. They are dealt to the
+	// workers in order, so the first ones start first. Only call when idle.
+	void Run(const std::vector<uint32_t>& tasks, Task task);
+
+	// Drops the tasks that have not started yet and waits for the rest
+	void Cancel();
+
+	void Wait();
+	bool IsBusy() const { return m_Pending.load(std::memory_order_acquire) != 0; }
+
+	uint32_t GetThreadCount() const { return (uint32_t)m_Threads.size(); }
+
+private:
+	struct alignas(64) Queue
+	{
+		std::mutex mutex;
+		std::deque<uint32_t> tasks;
+	};
+
+	void Work(uint32_t thread);
+	bool Take(uint32_t thread, uint32_t& task);
+	void Finished(size_t count);
+
+	std::vector<std::thread> m_Threads;
+	std::vector<Queue> m_Queues;
+	Task m_Task;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_Wake;
+	std::condition_variable m_Done;
+	uint64_t m_Generation = 0;
+	bool m_Stop = false;
+
+	std::atomic<size_t> m_Pending = 0;
+};
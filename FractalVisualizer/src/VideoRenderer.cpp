@@ -2,6 +2,8 @@
 
 #define _USE_MATH_DEFINES
 #include <math.h>
+#include <algorithm>
+#include <unordered_map>
 #include <imgui_internal.h>
 
 template<typename T>
@@ -24,109 +26,94 @@ T lerp(T a, T b, S t)
 
 static inline ImVec2 operator*(const float scalar, const ImVec2& vec) { return vec * scalar; }
 
-template<typename T>
-T CatmullRom(const KeyFrame<T>& p0, const KeyFrame<T>& p1, const KeyFrame<T>& p2, const KeyFrame<T>& p3, double t)
-{
-	t -= p1.t;
-	const double t1 = p2.t - p1.t;
-
-	const T& r0 = p0.val;
-	const T& r1 = p1.val;
-	const T& r2 = p2.val;
-	const T& r3 = p3.val;
-
-	const T a = (T)(-((r0 + r1 - r2 - r3) * t1 - 4.0 * r1 + 4.0 * r2) / (2.0 * t1 * t1 * t1));
-	const T b = (T)(((2.0 * r0 + r1 - 2.0 * r2 - r3) * t1 - 6.0 * r1 + 6.0 * r2) / (2.0 * t1 * t1));
-	const T c = (T)((r2 - r0) / 2.0);
-	const T d = (T)r1;
-
-	return (T)(a * t * t * t + b * t * t + c * t + d);
-}
+// 5 point Gauss-Legendre, exact for the polynomials up to degree 9
+static const double s_GaussNodes[5] = { 0.0, -0.5384693101056831, 0.5384693101056831, -0.9061798459386640, 0.9061798459386640 };
+static const double s_GaussWeights[5] = { 0.5688888888888889, 0.4786286704993665, 0.4786286704993665, 0.2369268850561891, 0.2369268850561891 };
 
-template<typename T>
-T Hermite(const KeyFrame<T>& p0, const KeyFrame<T>& p1, const T& v0, const T& v1, double t)
+static double ArcLength(const Cubic<glm::dvec2>& segment, double t0, double t1)
 {
-	t = t - p0.t;
-	double t1 = p1.t - p0.t;
-
-	T a = (2.0 * (p0.val - p1.val) + t1 * (v0 + v1)) / std::pow(t1, 3);
-	T b = -(3.0 * (p0.val - p1.val) + t1 * (2.0 * v0 + v1)) / std::pow(t1, 2);
-	T c = v0;
-	T d = p0.val;
+	const double half = (t1 - t0) * 0.5;
+	const double mid = (t1 + t0) * 0.5;
 
-	return a * t * t * t + b * t * t + c * t + d;
+	double sum = 0.0;
+	for (int i = 0; i < 5; i++)
+		sum += s_GaussWeights[i] * glm::length(segment.Derivative(mid + half * s_GaussNodes[i]));
+	return sum * half;
 }
 
-glm::dvec2 Hermite(const KeyFrame<CenterKey>& p0, const KeyFrame<CenterKey>& p1, double t)
+// Halves the intervals until both halves add up to the whole. The speed is
+// smooth except where it gets close to 0, so only those parts go deep.
+static void BuildArcLength(const Cubic<glm::dvec2>& segment, double t0, double t1, double whole, double tolerance, int depth, ArcLengthTable& table)
 {
-	t = t - p0.t;
-	double t1 = p1.t - p0.t;
+	static const int MIN_DEPTH = 4;
+	static const int MAX_DEPTH = 30;
 
-	glm::dvec2 a = (2.0 * (p0.val.pos - p1.val.pos) + t1 * (p0.val.vel + p1.val.vel)) / std::pow(t1, 3);
-	glm::dvec2 b = -(3.0 * (p0.val.pos - p1.val.pos) + t1 * (2.0 * p0.val.vel + p1.val.vel)) / std::pow(t1, 2);
-	glm::dvec2 c = p0.val.vel;
-	glm::dvec2 d = p0.val.pos;
+	const double mid = (t0 + t1) * 0.5;
+	const double left = ArcLength(segment, t0, mid);
+	const double right = ArcLength(segment, mid, t1);
 
-	return a * t * t * t + b * t * t + c * t + d;
-}
- 
-double HermiteLength(const KeyFrame<CenterKey>& p0, const KeyFrame<CenterKey>& p1)
-{
-	constexpr int segments = 1000;
-	double sum = 0.0;
-	for (int i = 0; i <= segments; i++)
+	if (depth >= MAX_DEPTH || (depth >= MIN_DEPTH && std::abs(left + right - whole) <= tolerance))
 	{
-		double t = map(i / (double)segments, 0.0, 1.0, p0.t, p1.t);
-		double t1 = map((i + 1) / (double)segments, 0.0, 1.0, p0.t, p1.t);
-
-		auto p = Hermite(p0, p1, t);
-		auto q = Hermite(p0, p1, t1);
-
-		sum += glm::length(q - p);
+		const double start = table.s.back();
+		table.t.push_back(mid);
+		table.s.push_back(start + left);
+		table.t.push_back(t1);
+		table.s.push_back(start + left + right);
+		return;
 	}
-	return sum;
+
+	BuildArcLength(segment, t0, mid, left, tolerance * 0.5, depth + 1, table);
+	BuildArcLength(segment, mid, t1, right, tolerance * 0.5, depth + 1, table);
 }
 
-template<typename T>
-T CatmullRomInterp(const KeyFrameList<T>& keys, double t)
+// Time since the start of the segment at which the arc length is `s`
+static double InvertArcLength(const Cubic<glm::dvec2>& segment, const ArcLengthTable& table, double s)
 {
-	// Assuming ordered keyframes
-	if (t <= keys.front()->t)
-		return keys.front()->val;
-
-	if (t >= keys.back()->t)
-		return keys.back()->val;
-
-	for (int i = 0; i < keys.size() - 1; i++)
+	if (s <= 0.0)
+		return table.t.front();
+	if (s >= table.s.back())
+		return table.t.back();
+
+	const size_t i = std::upper_bound(table.s.begin(), table.s.end(), s) - table.s.begin() - 1;
+	const double t0 = table.t[i];
+	const double t1 = table.t[i + 1];
+
+	// The speed barely changes within an interval, so the linear guess is
+	// close and Newton converges in a step or two
+	double t = map(s, table.s[i], table.s[i + 1], t0, t1);
+	for (int k = 0; k < 4; k++)
 	{
-		auto p1 = *keys[i + 0];
-		auto p2 = *keys[i + 1];
-
-		if (p1.t <= t && t <= p2.t)
-		{
-			auto p0 = i > 0 ? *keys[i - 1] : KeyFrame<T>(2.0 * p1.t - p2.t, T(2.0 * p1.val) - p2.val);
-			auto p3 = i < keys.size() - 2 ? *keys[i + 2] : KeyFrame<T>(2.0 * p2.t - p1.t, T(2.0 * p2.val) - p1.val);
-
-			T v0 = (p2.val - p0.val) / (p2.t - p0.t);
-			T v1 = (p3.val - p1.val) / (p3.t - p1.t);
-
-			return Hermite<T>(p1, p2, v0, v1, t);
-			// return CatmullRom(p0, p1, p2, p3, t);
-		}
+		const double speed = glm::length(segment.Derivative(t));
+		if (speed <= 0.0)
+			break;
+
+		const double error = table.s[i] + ArcLength(segment, t0, t) - s;
+		const double next = std::clamp(t - error / speed, t0, t1);
+		if (std::abs(next - t) <= (t1 - t0) * 1e-12)
+			return next;
+		t = next;
 	}
-	assert(false && "YO WTF?");
-	return T();
+	return t;
 }
 
 void VideoRenderer::Prepare(std::filesystem::path path, const FractalVisualizer& other)
 {
-	fract = std::make_unique<FractalVisualizer>(path);
+	// The same fractal keeps its shaders and buffers
+	if (!fract || path != m_FractalPath)
+	{
+		fract = std::make_unique<FractalVisualizer>(path);
+		m_FractalPath = path;
+	}
+	else
+		fract->ResetRender();
+
 	fract->SetColorFunction(color);
-	fract->SetSmoothColor(other.GetSmoothColor());
-	fract->SetFadeThreshold(other.GetFadeThreshold());
-	fract->SetIterationsPerFrame(other.GetIterationsPerFrame());
+	fract->CopySettings(other);
 	fract->SetSize(resolution);
 
+	// Key frames only store doubles, so deep zooms are relative to this center
+	m_DeepAnchor = other.GetDeepCenter();
+
 	steps = (size_t)std::ceil(fps * duration);
 
 	current_iter = 0;
@@ -135,6 +122,25 @@ void VideoRenderer::Prepare(std::filesystem::path path, const FractalVisualizer&
 	// Update();
 }
 
+void VideoRenderer::CopySettings(const VideoRenderer& other)
+{
+	fileName = other.fileName;
+	resolution = other.resolution;
+	duration = other.duration;
+	fps = other.fps;
+	steps_per_frame = other.steps_per_frame;
+	cAmplitude = other.cAmplitude;
+	cCenter = other.cCenter;
+
+	radiusKeyFrames = other.radiusKeyFrames;
+	centerKeyFrames = other.centerKeyFrames;
+
+	// The uniforms of the copy are in the same order
+	SetColorFunction(other.color);
+	for (size_t i = 0; i < uniformsKeyFrames.size(); i++)
+		uniformsKeyFrames[i].second = other.uniformsKeyFrames[i].second;
+}
+
 void VideoRenderer::Invalidate()
 {
 	InvalidateCenter();
@@ -143,74 +149,61 @@ void VideoRenderer::Invalidate()
 
 void VideoRenderer::InvalidateCenter()
 {
-	m_CurrentT = 0.0;
-	m_CurrentLocalT = centerKeyFrames.front()->t;
-	m_CurrentS = 0.0;
-	m_CenterSegment = 0;
-
-	m_SegmentsLength.clear();
-	m_SegmentsLength.reserve(centerKeyFrames.size() - 1);
-	for (int i = 1; i < centerKeyFrames.size(); i++)
+	// Only the segments fitted again since the last time are measured
+	std::unordered_map<uint64_t, ArcLengthTable> previous;
+	for (ArcLengthTable& table : m_CenterArcs)
+		previous.emplace(table.revision, std::move(table));
+
+	const size_t count = centerKeyFrames.GetSegmentCount();
+	m_CenterArcs.clear();
+	m_CenterArcs.reserve(count);
+	for (size_t i = 0; i < count; i++)
 	{
-		auto a = centerKeyFrames[i - 1];
-		auto b = centerKeyFrames[i];
-		m_SegmentsLength.push_back(HermiteLength(*a, *b));
+		const uint64_t revision = centerKeyFrames.GetRevision(i);
+		if (auto it = previous.find(revision); it != previous.end())
+		{
+			m_CenterArcs.push_back(std::move(it->second));
+			continue;
+		}
+
+		ArcLengthTable& table = m_CenterArcs.emplace_back();
+		table.revision = revision;
+		table.t.push_back(0.0);
+		table.s.push_back(0.0);
+
+		// Relative to the length, the paths of deep zooms are tiny
+		const Cubic<glm::dvec2>& segment = centerKeyFrames.GetSegment(i);
+		const double end = centerKeyFrames.GetTime(i + 1) - centerKeyFrames.GetTime(i);
+		const double whole = ArcLength(segment, 0.0, end);
+		if (end > 0.0)
+			BuildArcLength(segment, 0.0, end, whole, whole * 1e-10, 0, table);
 	}
 }
 
 void VideoRenderer::InvalidateRadius(double dt)
 {
-	m_RadiusIntegPoints.clear();
-
-	double acc = 0.0;
 	const int samples = (int)(1.0 / dt);
 	dt = 1.0 / (double)(samples - 1);
-	m_RadiusIntegPoints.reserve(samples);
+
+	std::vector<double> times(samples);
 	for (int i = 0; i < samples; i++)
+		times[i] = i / (double)(samples - 1);
+
+	m_RadiusIntegPoints.resize(samples);
+	radiusKeyFrames.Evaluate(times, m_RadiusIntegPoints);
+
+	double acc = 0.0;
+	for (double& radius : m_RadiusIntegPoints)
 	{
-		const double t = i / (double)(samples - 1);
-		acc += GetRadius(t) * dt;
-		m_RadiusIntegPoints.push_back(acc);
+		acc += radius * dt;
+		radius = acc;
 	}
 }
 
 double VideoRenderer::GetRadius(double t) const
 {
 	assert(0.0 <= t && t <= 1.0);
-
-	auto& keys = radiusKeyFrames;
-
-	// Assuming ordered keyframes
-	if (t <= keys.front()->t)
-		return keys.front()->val;
-
-	if (t >= keys.back()->t)
-		return keys.back()->val;
-
-	for (int i = 0; i < keys.size() - 1; i++)
-	{
-		auto p1 = *keys[i + 0];
-		auto p2 = *keys[i + 1];
-
-		if (p1.t <= t && t <= p2.t)
-		{
-			static auto LogProject = [](double v1, double v2) -> double { return exp(2.0 * std::log(v1) - std::log(v2)); };
-			auto p0 = i > 0 ? *keys[i - 1] : KeyFrame(2.0 * p1.t - p2.t, LogProject(p1.val, p2.val));
-			auto p3 = i < keys.size() - 2 ? *keys[i + 2] : KeyFrame(2.0 * p2.t - p1.t, LogProject(p2.val, p1.val));
-
-			p0.val = std::log(p0.val);
-			p1.val = std::log(p1.val);
-			p2.val = std::log(p2.val);
-			p3.val = std::log(p3.val);
-
-			double v0 = (p2.val - p0.val) / (p2.t - p0.t);
-			double v1 = (p3.val - p1.val) / (p3.t - p1.t);
-
-			return std::exp(Hermite(p1, p2, v0, v1, t));
-		}
-	}
-	assert(false && "YO WTF?");
-	return 0.0;
+	return radiusKeyFrames.Evaluate(t);
 }
 
 double VideoRenderer::GetRadiusInteg(double t) const
@@ -229,60 +222,33 @@ double VideoRenderer::GetRadiusInteg(double t) const
 	return a * (1.0 - lt) + b * lt;
 }
 
-glm::dvec2 VideoRenderer::GetCenter(double t, double precision)
+glm::dvec2 VideoRenderer::GetCenter(double t) const
 {
 	assert(0.0 <= t && t <= 1.0);
 
-	double dt = t - m_CurrentT;
-	m_CurrentT = t;
-
 	auto& center = centerKeyFrames;
 
-	if (t <= center.front()->t)
-		return center.front()->val.pos;
+	if (t <= center.GetTime(0))
+		return center.GetValue(0).pos;
 
-	if (t >= center.back()->t)
-		return center.back()->val.pos;
+	if (t >= center.GetTime(center.Size() - 1))
+		return center.GetValue(center.Size() - 1).pos;
+
+	const size_t segment = center.FindSegment(t);
+	const double t0 = center.GetTime(segment);
+	const double t1 = center.GetTime(segment + 1);
+	const ArcLengthTable& table = m_CenterArcs[segment];
 
-	double sign = dt >= 0 ? 1 : -1;
-	auto a = center[m_CenterSegment];
-	auto b = center[m_CenterSegment + 1];
-	while (m_CurrentT > b->t)
-	{
-		m_CenterSegment++;
-		a = center[m_CenterSegment];
-		b = center[m_CenterSegment + 1];
-		m_CurrentLocalT = a->t;
-		m_CurrentS = 0.0;
-	}
-	while (m_CurrentT < a->t)
-	{
-		m_CenterSegment--;
-		a = center[m_CenterSegment];
-		b = center[m_CenterSegment + 1];
-		m_CurrentLocalT = b->t;
-		m_CurrentS = m_SegmentsLength[m_CenterSegment];
-	}
-	
-	const double total_length = m_SegmentsLength[m_CenterSegment];
 	const double target_length = map(
 		GetRadiusInteg(t),
-		GetRadiusInteg(a->t),
-		GetRadiusInteg(b->t),
-		0.0, 
-		total_length
+		GetRadiusInteg(t0),
+		GetRadiusInteg(t1),
+		0.0,
+		table.s.back()
 	);
 
-	double step = std::abs(dt) * precision;
-	auto prev = Hermite(*a, *b, m_CurrentLocalT);
-	while (m_CurrentS * sign < target_length * sign)
-	{
-		m_CurrentLocalT += step * sign;
-		auto curr = Hermite(*a, *b, m_CurrentLocalT);
-		m_CurrentS += glm::length(curr - prev) * sign;
-		prev = curr;
-	}
-	return prev;
+	const Cubic<glm::dvec2>& cubic = center.GetSegment(segment);
+	return cubic(InvertArcLength(cubic, table, target_length));
 }
 
 void VideoRenderer::UpdateIter(double t)
@@ -292,13 +258,19 @@ void VideoRenderer::UpdateIter(double t)
 	auto new_radius = GetRadius(t);
 	fract->SetRadius(new_radius);
 
+	// The double-double kernel also reads the low part of the deep center
 	auto new_center = GetCenter(t);
-	fract->SetCenter(new_center);
+	if (fract->GetPerturbation() || fract->GetPrecision() == Precision::DoubleDouble)
+	{
+		fract->SetDeepCenter(m_DeepAnchor);
+		fract->MoveCenter(new_center - m_DeepAnchor.ToDouble());
+	}
+	else
+		fract->SetCenter(new_center);
 
 	for (auto& [u, keys] : uniformsKeyFrames)
 	{
-		auto new_val = CatmullRomInterp(keys, t);
-		u->val = new_val;
+		u->val = keys.Evaluate(t);
 	}
 
 	glm::dvec2 cValue = {
@@ -306,12 +278,13 @@ void VideoRenderer::UpdateIter(double t)
 		cCenter.y + cAmplitude * sin(2.0 * IM_PI * t) 
 	};
 
-	glUseProgram(fract->GetShader());
-	GLint loc = glGetUniformLocation(fract->GetShader(), "i_JuliaC");
-	glUniform2d(loc, cValue.x, cValue.y);
+	fract->SetJuliaC(cValue);
 
-	for (int f = 0; f < steps_per_frame; f++)
+	for (int f = 0; f < steps_per_frame || !fract->HasRunSteps(steps_per_frame); f++)
+	{
 		fract->Update();
+		fract->Finish();
+	}
 }
 
 void VideoRenderer::SetColorFunction(const std::shared_ptr<ColorFunction>& new_color)
@@ -326,7 +299,7 @@ void VideoRenderer::SetColorFunction(const std::shared_ptr<ColorFunction>& new_c
 			auto p = dynamic_cast<FloatUniform*>(u);
 			auto& keyFrames = uniformsKeyFrames.emplace_back();
 			keyFrames.first = p;
-			keyFrames.second.emplace_back(std::make_shared<KeyFrame<float>>(0.0, p->val));
+			keyFrames.second.Insert(0.0, p->val);
 		}
 	}
 }
@@ -336,3 +309,63 @@ void VideoRenderer::UpdateToFractal()
 	fract->SetSize(resolution);
 	fract->SetColorFunction(color);
 }
+
+bool VideoRenderer::BeginEncoding()
+{
+	// Made by the fractal, which Prepare may have replaced
+	m_Yuv = std::make_unique<YuvConvert>(fract->GetQuadVA());
+	m_Yuv->Resize(resolution);
+	const glm::uvec2 frame = m_Yuv->GetFrameSize();
+
+	std::stringstream cmd;
+	cmd << "ffmpeg ";
+	cmd << "-y ";
+	cmd << "-loglevel error ";
+
+	// Already flipped, padded and converted, the tags keep ffmpeg from converting again
+	cmd << "-r " << fps << " ";
+	cmd << "-f rawvideo ";
+	cmd << "-pix_fmt yuv420p ";
+	cmd << "-color_range tv -colorspace bt709 -color_primaries bt709 -color_trc bt709 ";
+	cmd << "-s " << frame.x << "x" << frame.y << " ";
+	cmd << "-i - ";
+
+	cmd << "-vcodec libx264 ";
+	cmd << "-pix_fmt yuv420p ";
+	cmd << "-crf 15 ";
+	cmd << "\"" << fileName << "\"";
+
+	if (!m_Encoder.Open(cmd.str(), m_Yuv->GetFrameBytes()))
+	{
+		LOG_ERROR("Failed to start ffmpeg");
+		return false;
+	}
+
+	current_iter = 0;
+	return true;
+}
+
+EncodeStatus VideoRenderer::EncodeFrame()
+{
+	// The rest of the frames would only be dropped
+	const bool failed = m_Encoder.HasFailed();
+	if (failed || (size_t)current_iter >= steps)
+	{
+		const bool closed = m_Encoder.Close();
+		m_Yuv.reset();
+
+		if (failed || !closed)
+		{
+			LOG_ERROR("ffmpeg failed to encode {}", fileName);
+			return EncodeStatus::Failed;
+		}
+		return EncodeStatus::Done;
+	}
+
+	UpdateIter(current_iter / (float)(steps - 1));
+	m_Yuv->Draw(fract->GetTexture());
+	m_Encoder.Push(m_Yuv->GetTexture(), GL_RED, GL_UNSIGNED_BYTE);
+
+	current_iter++;
+	return EncodeStatus::Running;
+}
@@ -3,28 +3,36 @@
 #include <GLCore.h>
 
 #include "FractalVisualizer.h"
+#include "AnimationTrack.h"
+#include "FramePipe.h"
+#include "YuvConvert.h"
 
-template<typename T>
-struct KeyFrame
+// Arc length of a segment of the center path from its first key frame to the
+// ends of the intervals the quadrature settled on, see InvalidateCenter
+struct ArcLengthTable
 {
-	KeyFrame(double t, T val) : t(t), val(val) {}
-	double t;
-	T val;
+	uint64_t revision = 0; // Of the segment it measured
+	std::vector<double> t = {};
+	std::vector<double> s = {};
 };
 
-struct CenterKey
+enum class EncodeStatus
 {
-	glm::dvec2 pos;
-	glm::dvec2 vel;
+	Running = 0,
+	Done,
+	Failed // ffmpeg could not take or encode the frames
 };
 
-template<typename T>
-using KeyFrameList = std::vector<std::shared_ptr<KeyFrame<T>>>;
-
 class VideoRenderer
 {
 public:
+	// Takes the settings of `other`. The fractal is only created again when
+	// the source changes, otherwise it keeps its shaders and buffers.
 	void Prepare(std::filesystem::path, const FractalVisualizer& other);
+	// Takes the settings and key frames of `other`, copied so that editing
+	// them afterwards does not change this one. Call before Prepare.
+	void CopySettings(const VideoRenderer& other);
+
 	void UpdateIter(double t);
 	void SetColorFunction(const std::shared_ptr<ColorFunction>& new_color);
 	void UpdateToFractal();
@@ -32,15 +40,22 @@ public:
 	void InvalidateRadius(double dt = 1e-4);
 	void InvalidateCenter();
 
+	// Starts ffmpeg, encoding into `fileName`. Call after Prepare. The frames
+	// are converted to yuv420p before they are read back, see YuvConvert.
+	bool BeginEncoding();
+
+	// Renders the next frame and queues it for ffmpeg. Once every frame is
+	// done it waits for the ones in flight and closes the pipe. As soon as
+	// the pipe fails it closes it and stops rendering.
+	EncodeStatus EncodeFrame();
+
 	double GetRadius(double t) const;
 	double GetRadiusInteg(double t) const;
 
-	glm::dvec2 GetCenter(double t, double precision = 1e-3);
-
-	int m_CenterSegment = 0;
-	double m_CurrentT = 0.0;
-	double m_CurrentLocalT = 0.0;
-	double m_CurrentS = 0.0;
+	// Moves along the path at a speed proportional to the radius. Only reads
+	// the tables of InvalidateCenter and InvalidateRadius, so any frame can be
+	// asked for, from any thread.
+	glm::dvec2 GetCenter(double t) const;
 
 	std::string fileName = "output.mp4";
 	std::unique_ptr<FractalVisualizer> fract;
@@ -51,35 +66,41 @@ public:
 	int fps = 30;
 	int steps_per_frame = 10;
 
-	FILE* ffmpeg;
-	BYTE* pixels;
+	FramePipe m_Encoder;
+	std::unique_ptr<YuvConvert> m_Yuv;
 
 	size_t steps;
 
 	int current_iter = 0;
 
-	std::vector<double> m_SegmentsLength;
+	std::vector<ArcLengthTable> m_CenterArcs;
 	std::vector<double> m_RadiusIntegPoints;
 
-	KeyFrameList<double> radiusKeyFrames = {
-		std::make_shared<KeyFrame<double>>(0.0, 1.0),
-		// std::make_shared<KeyFrame<double>>(0.0, 1.0),
-		// std::make_shared<KeyFrame<double>>(0.33, 0.008057857721976197),
-		// std::make_shared<KeyFrame<double>>(0.500, 0.28782969446188766),
-		// std::make_shared<KeyFrame<double>>(0.632, 0.006049181474278884),
-		// std::make_shared<KeyFrame<double>>(0.795, 1.172453080986668e-05),
-		// std::make_shared<KeyFrame<double>>(1.0, 1.0),
+	AnimationTrack<double> radiusKeyFrames = {
+		{
+			{ 0.0, 1.0 },
+			// { 0.0, 1.0 },
+			// { 0.33, 0.008057857721976197 },
+			// { 0.500, 0.28782969446188766 },
+			// { 0.632, 0.006049181474278884 },
+			// { 0.795, 1.172453080986668e-05 },
+			// { 1.0, 1.0 },
+		},
+		TrackSpace::Log
 	};
-	KeyFrameList<CenterKey> centerKeyFrames = {
-		std::make_shared<KeyFrame<CenterKey>>(0.0, CenterKey{ {0.0, 0.0}, {0.0, 0.0} }),
-		// std::make_shared<KeyFrame<CenterKey>>(0, CenterKey{ {-0.5, 0}, {0.0, 0.0} }),
-		// std::make_shared<KeyFrame<CenterKey>>(0.33, CenterKey{{-1.2558024544068163, 0.38112841375594236}, {0.0, 0.0}}),
-		// std::make_shared<KeyFrame<CenterKey>>(0.500, CenterKey{{-0.8392324486465885, 0.37356936504006194}, {0.0, 0.0}}),
-		// std::make_shared<KeyFrame<CenterKey>>(0.632, CenterKey{{-0.5973014418167584, 0.6631019637438973}, {0.0, 0.0}}),
-		// std::make_shared<KeyFrame<CenterKey>>(0.795, CenterKey{{-0.5952023547186579, 0.6680937984694201}, {0.0, 0.0}}),
-		// std::make_shared<KeyFrame<CenterKey>>(1.0, CenterKey{ {-0.5, 0}, {0.0, 0.0} }),
+	AnimationTrack<CenterKey> centerKeyFrames = {
+		{ 0.0, CenterKey{ {0.0, 0.0}, {0.0, 0.0} } },
+		// { 0, CenterKey{ {-0.5, 0}, {0.0, 0.0} } },
+		// { 0.33, CenterKey{{-1.2558024544068163, 0.38112841375594236}, {0.0, 0.0}} },
+		// { 0.500, CenterKey{{-0.8392324486465885, 0.37356936504006194}, {0.0, 0.0}} },
+		// { 0.632, CenterKey{{-0.5973014418167584, 0.6631019637438973}, {0.0, 0.0}} },
+		// { 0.795, CenterKey{{-0.5952023547186579, 0.6680937984694201}, {0.0, 0.0}} },
+		// { 1.0, CenterKey{ {-0.5, 0}, {0.0, 0.0} } },
 	};
-	std::vector<std::pair<FloatUniform*, KeyFrameList<float>>> uniformsKeyFrames;
+	std::vector<std::pair<FloatUniform*, AnimationTrack<float>>> uniformsKeyFrames;
 	double cAmplitude = 1e-5;
 	glm::dvec2 cCenter = { 0.0, 0.0 };
+
+	BigComplex m_DeepAnchor;
+	std::filesystem::path m_FractalPath;
 };
\ No newline at end of file
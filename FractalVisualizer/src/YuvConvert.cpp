@@ -0,0 +1,115 @@
+#include "YuvConvert.h"
+#include "ProgramCache.h"
+
+
+static const char* s_ConvertSrc = R"(#version 400 core
+layout (location = 0) out float o_Byte;
+
+uniform sampler2D i_Image;
+uniform ivec2 i_Size;
+
+const vec3 luma_weights = vec3(0.2126, 0.7152, 0.0722);
+
+// Top row first, black past the edges like ffmpeg's pad
+vec3 frame_pixel(ivec2 p)
+{
+    if (p.x >= i_Size.x || p.y >= i_Size.y)
+        return vec3(0.0);
+    return texelFetch(i_Image, ivec2(p.x, i_Size.y - 1 - p.y), 0).rgb;
+}
+
+void main()
+{
+    ivec2 frame = (i_Size + 1) / 2 * 2;
+
+    // Byte of the frame this texel holds, the texture is as wide as the frame
+    int offset = int(gl_FragCoord.y) * frame.x + int(gl_FragCoord.x);
+
+    int lumaBytes = frame.x * frame.y;
+    if (offset < lumaBytes)
+    {
+        vec3 c = frame_pixel(ivec2(offset % frame.x, offset / frame.x));
+        o_Byte = (16.0 + 219.0 * dot(c, luma_weights)) / 255.0;
+        return;
+    }
+
+    // Every chroma sample covers 2x2 pixels, first all the U then all the V
+    offset -= lumaBytes;
+    int chromaBytes = lumaBytes / 4;
+    bool v = offset >= chromaBytes;
+    offset %= chromaBytes;
+
+    ivec2 p = ivec2(offset % (frame.x / 2), offset / (frame.x / 2)) * 2;
+    vec3 c = (frame_pixel(p) + frame_pixel(p + ivec2(1, 0)) + frame_pixel(p + ivec2(0, 1)) + frame_pixel(p + ivec2(1, 1))) * 0.25;
+
+    float y = dot(c, luma_weights);
+    float chroma = v ? (c.r - y) / 1.5748 : (c.b - y) / 1.8556;
+    o_Byte = (128.0 + 224.0 * chroma) / 255.0;
+}
+)";
+
+YuvConvert::YuvConvert(GLuint quadVA)
+	: m_QuadVA(quadVA)
+{
+	m_Program = CreateCachedShader(s_ConvertSrc);
+	glUseProgram(m_Program);
+
+	glUniform1i(glGetUniformLocation(m_Program, "i_Image"), 0);
+	m_SizeLocation = glGetUniformLocation(m_Program, "i_Size");
+}
+
+YuvConvert::~YuvConvert()
+{
+	glDeleteProgram(m_Program);
+	glDeleteFramebuffers(1, &m_FBO);
+	glDeleteTextures(1, &m_Texture);
+}
+
+void YuvConvert::Resize(const glm::uvec2& size)
+{
+	if (m_Size == size)
+		return;
+
+	m_Size = size;
+	const glm::uvec2 frame = GetFrameSize();
+
+	glDeleteFramebuffers(1, &m_FBO);
+	glDeleteTextures(1, &m_Texture);
+
+	glGenTextures(1, &m_Texture);
+	glBindTexture(GL_TEXTURE_2D, m_Texture);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_R8, frame.x, frame.y * 3 / 2);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	glGenFramebuffers(1, &m_FBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_Texture, 0);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		LOG_ERROR("Failed to create yuv framebuffer ({0}, {1})", frame.x, frame.y * 3 / 2);
+		exit(EXIT_FAILURE);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void YuvConvert::Draw(GLuint image)
+{
+	const glm::uvec2 frame = GetFrameSize();
+
+	glUseProgram(m_Program);
+	glUniform2i(m_SizeLocation, (int)m_Size.x, (int)m_Size.y);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, image);
+
+	glViewport(0, 0, frame.x, frame.y * 3 / 2);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+	glDisable(GL_BLEND);
+
+	glBindVertexArray(m_QuadVA);
+	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <GLCore.h>
+
+// Turns the image into the I420 frame ffmpeg encodes: BT.709, limited range,
+// top row first and padded with black to even dimensions. The texture holds
+// the bytes of the frame as they are piped, the Y plane followed by the U and
+// V ones, so reading it back moves 1.5 bytes per pixel instead of 4.
+class YuvConvert
+{
+public:
+	// `quadVA` is the full screen quad the frame is drawn with
+	YuvConvert(GLuint quadVA);
+	~YuvConvert();
+
+	// Size of the image, the frame is padded from it
+	void Resize(const glm::uvec2& size);
+
+	void Draw(GLuint image);
+
+	GLuint GetTexture() const { return m_Texture; }
+
+	// Size of the frame, even in both dimensions
+	glm::uvec2 GetFrameSize() const { return (m_Size + 1u) / 2u * 2u; }
+	size_t GetFrameBytes() const { return (size_t)GetFrameSize().x * GetFrameSize().y * 3 / 2; }
+
+private:
+	GLuint m_Program = 0;
+	GLint m_SizeLocation = -1;
+
+	GLuint m_QuadVA;
+	GLuint m_FBO = 0;
+	GLuint m_Texture = 0;
+
+	glm::uvec2 m_Size = { 0, 0 };
+};
@@ -0,0 +1,125 @@
+#include "ZoomPreview.h"
+#include "ProgramCache.h"
+
+
+static const char* s_BlendSrc = R"(#version 400 core
+layout (location = 0) out vec4 o_Color;
+
+uniform sampler2D i_Last;
+uniform sampler2D i_New;
+
+uniform vec2 i_Size;
+uniform float i_Scale;  // Radius of the new view over the one of the full render
+uniform vec2 i_Offset;  // Texture coordinates of the new center in the full render
+uniform float i_Amount;
+
+void main()
+{
+    vec2 uv = gl_FragCoord.xy / i_Size;
+    vec4 new_color = texture(i_New, uv);
+
+    vec2 last_uv = (uv - 0.5) * i_Scale + i_Offset;
+    if (any(lessThan(last_uv, vec2(0.0))) || any(greaterThan(last_uv, vec2(1.0))))
+        o_Color = new_color;
+    else
+        o_Color = mix(texture(i_Last, last_uv), new_color, i_Amount);
+}
+)";
+
+ZoomPreview::ZoomPreview(GLuint quadVA)
+	: m_QuadVA(quadVA)
+{
+	m_Program = CreateCachedShader(s_BlendSrc);
+	glUseProgram(m_Program);
+
+	glUniform1i(glGetUniformLocation(m_Program, "i_Last"), 0);
+	glUniform1i(glGetUniformLocation(m_Program, "i_New"), 1);
+
+	m_SizeLocation = glGetUniformLocation(m_Program, "i_Size");
+	m_ScaleLocation = glGetUniformLocation(m_Program, "i_Scale");
+	m_OffsetLocation = glGetUniformLocation(m_Program, "i_Offset");
+	m_AmountLocation = glGetUniformLocation(m_Program, "i_Amount");
+}
+
+ZoomPreview::~ZoomPreview()
+{
+	glDeleteProgram(m_Program);
+	glDeleteFramebuffers(1, &m_FBO);
+	glDeleteTextures(1, &m_Texture);
+	glDeleteTextures(1, &m_Source);
+}
+
+void ZoomPreview::Resize(const glm::uvec2& size)
+{
+	if (m_Size == size)
+		return;
+
+	m_Size = size;
+
+	glDeleteFramebuffers(1, &m_FBO);
+	glDeleteTextures(1, &m_Texture);
+	glDeleteTextures(1, &m_Source);
+
+	GLuint textures[2];
+	glGenTextures(2, textures);
+	m_Texture = textures[0];
+	m_Source = textures[1];
+	for (GLuint texture : textures)
+	{
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, size.x, size.y);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+
+	glGenFramebuffers(1, &m_FBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_Texture, 0);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		LOG_ERROR("Failed to create zoom preview framebuffer ({0}, {1})", size.x, size.y);
+		exit(EXIT_FAILURE);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void ZoomPreview::Start(GLuint texture, const BigComplex& center, double radius)
+{
+	// Shown as is until the first blend
+	glCopyImageSubData(texture, GL_TEXTURE_2D, 0, 0, 0, 0, m_Source, GL_TEXTURE_2D, 0, 0, 0, 0, m_Size.x, m_Size.y, 1);
+	glCopyImageSubData(texture, GL_TEXTURE_2D, 0, 0, 0, 0, m_Texture, GL_TEXTURE_2D, 0, 0, 0, 0, m_Size.x, m_Size.y, 1);
+
+	m_Center = center;
+	m_Radius = radius;
+}
+
+void ZoomPreview::Blend(GLuint texture, const BigComplex& center, double radius, float amount)
+{
+	// The difference of the deep centers keeps its precision at any zoom,
+	// see BigFloat::ToDouble
+	const double sourcePixelSize = 2.0 * m_Radius / m_Size.y;
+	const glm::dvec2 offset = (center - m_Center).ToDouble() / (sourcePixelSize * glm::dvec2(m_Size)) + 0.5;
+
+	glUseProgram(m_Program);
+	glUniform2f(m_SizeLocation, (float)m_Size.x, (float)m_Size.y);
+	glUniform1f(m_ScaleLocation, (float)(radius / m_Radius));
+	glUniform2f(m_OffsetLocation, (float)offset.x, (float)offset.y);
+	glUniform1f(m_AmountLocation, amount);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, m_Source);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, texture);
+
+	glViewport(0, 0, m_Size.x, m_Size.y);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+	glDisable(GL_BLEND);
+
+	glBindVertexArray(m_QuadVA);
+	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <GLCore.h>
+
+#include "BigFloat.h"
+
+// Image shown while the view is moving. Every time the view changes, the last
+// full render is reprojected to the new view, scaled about the points that
+// stay in place, and the new render is blended over it. A few cheap samples a
+// frame are then enough to keep the motion smooth instead of showing the noise
+// of a render that starts over every frame. The full render is resampled once
+// for every image, so it does not get blurrier the longer the view moves.
+class ZoomPreview
+{
+public:
+	// `quadVA` is the full screen quad the image is drawn with
+	ZoomPreview(GLuint quadVA);
+	~ZoomPreview();
+
+	void Resize(const glm::uvec2& size);
+
+	// Keeps a copy of `texture`, the full render of the given view
+	void Start(GLuint texture, const BigComplex& center, double radius);
+
+	// Reprojects the full render to the given view and mixes `amount` of
+	// `texture`, rendered at that view, into it. The parts of the view the
+	// full render does not cover come only from `texture`.
+	void Blend(GLuint texture, const BigComplex& center, double radius, float amount);
+
+	GLuint GetTexture() const { return m_Texture; }
+
+private:
+	GLuint m_Program = 0;
+	GLint m_ScaleLocation = -1;
+	GLint m_OffsetLocation = -1;
+	GLint m_AmountLocation = -1;
+	GLint m_SizeLocation = -1;
+
+	GLuint m_QuadVA;
+	GLuint m_FBO = 0;
+	GLuint m_Texture = 0;
+	GLuint m_Source = 0; // The full render
+
+	glm::uvec2 m_Size = { 0, 0 };
+
+	// View of the full render
+	BigComplex m_Center;
+	double m_Radius = 1.0;
+};
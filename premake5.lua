@@ -23,4 +23,10 @@ group "Dependencies"
 group ""
 
 include "OpenGL-Core"
-include "FractalVisualizer"
\ No newline at end of file
+include "FractalVisualizer"
+include "FractalTests"
+
+-- Needs EGL, only for the Linux machines without a display
+if os.target() == "linux" then
+	include "FractalRender"
+end
\ No newline at end of file